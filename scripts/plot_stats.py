@@ -4,6 +4,7 @@ Generate time series graphs of power/bandwidth/energy...
 """
 
 import argparse
+import csv
 import json
 import os
 import sys
@@ -27,6 +28,22 @@ def extract_epoch_data(json_data, label, merge_channel=True):
                                        key=lambda t: t[0])]
 
 
+def load_stats(file_name):
+    """
+    load a stats file, epoch stats can also be NDJSON or CSV (epoch_format),
+    which are read line by line
+    """
+    if file_name.endswith('.ndjson'):
+        with open(file_name, 'r') as n_file:
+            return [json.loads(line) for line in n_file if line.strip()]
+    if file_name.endswith('.csv'):
+        with open(file_name, 'r') as c_file:
+            return [{k: float(v) if v else 0.0 for k, v in row.items()}
+                    for row in csv.DictReader(c_file)]
+    with open(file_name, 'r') as j_file:
+        return json.load(j_file)
+
+
 def plot_epochs(json_data, label, unit="", output=None):
     """
     plot the time series of a specified stat serie (e.g. bw, power, etc)
@@ -102,7 +119,7 @@ def plot_histogram(json_data, label, unit='', output=None):
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='Plot time serie graphs from '
                                      'stats outputs, type -h for more options')
-    parser.add_argument('json', help='stats json file')
+    parser.add_argument('json', help='stats json file, or epoch ndjson/csv file')
     parser.add_argument('-d', '--dir', help='output dir', default='.')
     parser.add_argument('-o', '--output',
                         help='output name (withouth extension name)',
@@ -112,17 +129,12 @@ if __name__ == '__main__':
                         'use the name in JSON')
     args = parser.parse_args()
 
-    with open(args.json, 'r') as j_file:
-        is_epoch = False
-        try:
-            j_data = json.load(j_file)
-        except:
-            print('cannot load file ' + args.json)
-            exit(1)
-        if isinstance(j_data, list):
-            is_epoch = True
-        else:
-            is_epoch = False
+    try:
+        j_data = load_stats(args.json)
+    except:
+        print('cannot load file ' + args.json)
+        exit(1)
+    is_epoch = isinstance(j_data, list)
 
     prefix = os.path.join(args.dir, args.output)
     if is_epoch:
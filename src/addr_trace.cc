@@ -0,0 +1,148 @@
+#include "addr_trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace dramsim3 {
+
+namespace {
+const char kAddrTraceMagic[8] = {'D', 'S', '3', 'A', 'D', 'D', 'R', '\0'};
+
+const size_t kAddrTraceBufferSize = 1 << 20;
+
+const uint8_t kKindRoiBegin = 2;
+const uint8_t kKindRoiEnd = 3;
+}  // namespace
+
+AddrTraceWriter::AddrTraceWriter(const std::string& file_name)
+    : buffer_(kAddrTraceBufferSize) {
+    // the buffer has to be installed before the file is opened
+    out_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+    out_.open(file_name, std::ofstream::out | std::ofstream::binary);
+    if (!out_) {
+        std::cerr << "Cannot open address trace " << file_name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    uint32_t record_size = sizeof(AddrTraceRecord);
+    out_.write(kAddrTraceMagic, sizeof(kAddrTraceMagic));
+    out_.write(reinterpret_cast<const char*>(&kAddrTraceVersion),
+               sizeof(kAddrTraceVersion));
+    out_.write(reinterpret_cast<const char*>(&record_size),
+               sizeof(record_size));
+}
+
+void AddrTraceWriter::Write(uint64_t addr, bool is_write, uint64_t cycle,
+                            uint32_t tag) {
+    AddrTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.addr = addr;
+    record.cycle = cycle;
+    record.tag = tag;
+    record.kind = is_write ? 1 : 0;
+    out_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+void AddrTraceWriter::WriteMarker(TraceRecordType type,
+                                  const std::string& roi_name,
+                                  uint64_t cycle) {
+    AddrTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+    std::memcpy(&record.addr, roi_name.data(),
+                std::min(roi_name.size(), sizeof(record.addr)));
+    record.cycle = cycle;
+    record.kind =
+        type == TraceRecordType::ROI_BEGIN ? kKindRoiBegin : kKindRoiEnd;
+    out_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+AddrTraceReader::AddrTraceReader(const std::string& file_name)
+    : in_(file_name, std::ifstream::in | std::ifstream::binary),
+      is_open_(in_.is_open()),
+      binary_(false) {
+    if (!is_open_) {
+        return;
+    }
+    char magic[sizeof(kAddrTraceMagic)];
+    uint32_t version = 0, record_size = 0;
+    in_.read(magic, sizeof(magic));
+    in_.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in_.read(reinterpret_cast<char*>(&record_size), sizeof(record_size));
+    if (in_.good() && std::memcmp(magic, kAddrTraceMagic, sizeof(magic)) == 0) {
+        if (version > kAddrTraceVersion ||
+            record_size != sizeof(AddrTraceRecord)) {
+            std::cerr << "Unsupported address trace version " << version
+                      << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        binary_ = true;
+    } else {
+        in_.clear();
+        in_.seekg(0);
+    }
+}
+
+bool AddrTraceReader::Next(TraceRecord& record) {
+    record.tag = 0;
+    record.roi_name.clear();
+    if (!binary_) {
+        std::string line;
+        while (std::getline(in_, line)) {
+            std::istringstream line_in(line);
+            std::string first;
+            if (!(line_in >> first)) {
+                continue;  // blank line
+            }
+            record.trans = Transaction();
+            if (first == "ROI_BEGIN") {
+                record.type = TraceRecordType::ROI_BEGIN;
+                line_in >> record.roi_name >> record.trans.added_cycle;
+                return static_cast<bool>(line_in);
+            } else if (first == "ROI_END") {
+                record.type = TraceRecordType::ROI_END;
+                return static_cast<bool>(line_in >> record.trans.added_cycle);
+            }
+            record.type = TraceRecordType::REQUEST;
+            line_in.clear();
+            line_in.seekg(0);
+            return static_cast<bool>(line_in >> record.trans);
+        }
+        return false;
+    }
+    AddrTraceRecord raw;
+    if (!in_.read(reinterpret_cast<char*>(&raw), sizeof(raw))) {
+        return false;
+    }
+    if (raw.kind == kKindRoiBegin || raw.kind == kKindRoiEnd) {
+        record.type = raw.kind == kKindRoiBegin ? TraceRecordType::ROI_BEGIN
+                                                : TraceRecordType::ROI_END;
+        const char* name = reinterpret_cast<const char*>(&raw.addr);
+        record.roi_name.assign(name, strnlen(name, sizeof(raw.addr)));
+        record.trans = Transaction();
+    } else {
+        record.type = TraceRecordType::REQUEST;
+        record.trans = Transaction(raw.addr, raw.kind != 0);
+        record.tag = raw.tag;
+    }
+    record.trans.added_cycle = raw.cycle;
+    return true;
+}
+
+bool AddrTraceReader::Next(Transaction& trans, uint32_t& tag) {
+    TraceRecord record;
+    while (Next(record)) {
+        if (record.type == TraceRecordType::REQUEST) {
+            trans = record.trans;
+            tag = record.tag;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AddrTraceReader::Next(Transaction& trans) {
+    uint32_t tag;
+    return Next(trans, tag);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,72 @@
+#ifndef __ADDR_TRACE_H
+#define __ADDR_TRACE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+
+namespace dramsim3 {
+
+// One accepted request. Like command traces the file starts with an 8 byte
+// magic, a version and the record size, followed by fixed width records.
+// ROI markers use the kind field and keep up to 8 characters of their
+// name in place of the address.
+struct AddrTraceRecord {
+    uint64_t addr;
+    uint64_t cycle;
+    uint32_t tag;
+    uint8_t kind;  // 0 read, 1 write, see TraceRecordType for markers
+    uint8_t reserved[3];
+};
+static_assert(sizeof(AddrTraceRecord) == 24, "trace records must be packed");
+
+// version 1 traces have no markers and are read as well
+const uint32_t kAddrTraceVersion = 2;
+
+enum class TraceRecordType { REQUEST, ROI_BEGIN, ROI_END };
+
+// A request or a region of interest marker, markers keep their cycle in
+// trans.added_cycle
+struct TraceRecord {
+    TraceRecordType type;
+    Transaction trans;
+    uint32_t tag;
+    std::string roi_name;
+};
+
+class AddrTraceWriter {
+   public:
+    explicit AddrTraceWriter(const std::string& file_name);
+    void Write(uint64_t addr, bool is_write, uint64_t cycle, uint32_t tag);
+    void WriteMarker(TraceRecordType type, const std::string& roi_name,
+                     uint64_t cycle);
+
+   private:
+    std::vector<char> buffer_;
+    std::ofstream out_;
+};
+
+// Reads binary address traces as well as text traces ("addr op cycle",
+// "ROI_BEGIN name cycle" and "ROI_END cycle" lines), the format is detected
+// from the file header
+class AddrTraceReader {
+   public:
+    explicit AddrTraceReader(const std::string& file_name);
+    bool IsOpen() const { return is_open_; }
+    bool IsBinary() const { return binary_; }
+    // returns false at the end of the trace, text traces have no tags
+    bool Next(TraceRecord& record);
+    // requests only, ROI markers are skipped
+    bool Next(Transaction& trans, uint32_t& tag);
+    bool Next(Transaction& trans);
+
+   private:
+    std::ifstream in_;
+    bool is_open_;
+    bool binary_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -1,4 +1,5 @@
 #include "bankstate.h"
+#include "checkpoint.h"
 
 namespace dramsim3 {
 
@@ -16,10 +17,12 @@ BankState::BankState()
     cmd_timing_[static_cast<int>(CommandType::REFRESH)] = 0;
     cmd_timing_[static_cast<int>(CommandType::SREF_ENTER)] = 0;
     cmd_timing_[static_cast<int>(CommandType::SREF_EXIT)] = 0;
+    cmd_timing_[static_cast<int>(CommandType::PD_ENTER)] = 0;
+    cmd_timing_[static_cast<int>(CommandType::PD_EXIT)] = 0;
 }
 
 
-Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
+CommandType BankState::GetRequiredType(const Command& cmd) const {
     CommandType required_type = CommandType::SIZE;
     switch (state_) {
         case State::CLOSED:
@@ -33,8 +36,11 @@ Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
                 case CommandType::REFRESH:
                 case CommandType::REFRESH_BANK:
                 case CommandType::SREF_ENTER:
+                case CommandType::PD_ENTER:
                     required_type = cmd.cmd_type;
                     break;
+                case CommandType::PRECHARGE:
+                    break;
                 default:
                     std::cerr << "Unknown type!" << std::endl;
                     AbruptExit(__FILE__, __LINE__);
@@ -56,8 +62,13 @@ Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
                 case CommandType::REFRESH:
                 case CommandType::REFRESH_BANK:
                 case CommandType::SREF_ENTER:
+                case CommandType::PRECHARGE:
                     required_type = CommandType::PRECHARGE;
                     break;
+                // active power-down keeps the row open
+                case CommandType::PD_ENTER:
+                    required_type = CommandType::PD_ENTER;
+                    break;
                 default:
                     std::cerr << "Unknown type!" << std::endl;
                     AbruptExit(__FILE__, __LINE__);
@@ -79,12 +90,35 @@ Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
             }
             break;
         case State::PD:
+            switch (cmd.cmd_type) {
+                case CommandType::READ:
+                case CommandType::READ_PRECHARGE:
+                case CommandType::WRITE:
+                case CommandType::WRITE_PRECHARGE:
+                case CommandType::ACTIVATE:
+                case CommandType::PRECHARGE:
+                case CommandType::REFRESH:
+                case CommandType::REFRESH_BANK:
+                case CommandType::SREF_ENTER:
+                case CommandType::PD_EXIT:
+                    required_type = CommandType::PD_EXIT;
+                    break;
+                default:
+                    std::cerr << "Unknown type!" << std::endl;
+                    AbruptExit(__FILE__, __LINE__);
+                    break;
+            }
+            break;
         case State::SIZE:
             std::cerr << "In unknown state" << std::endl;
             AbruptExit(__FILE__, __LINE__);
             break;
     }
+    return required_type;
+}
 
+Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
+    CommandType required_type = GetRequiredType(cmd);
     if (required_type != CommandType::SIZE) {
         if (clk >= cmd_timing_[static_cast<int>(required_type)]) {
             return Command(required_type, cmd.addr, cmd.hex_addr);
@@ -108,6 +142,9 @@ void BankState::UpdateState(const Command& cmd) {
                     open_row_ = -1;
                     row_hit_count_ = 0;
                     break;
+                case CommandType::PD_ENTER:
+                    state_ = State::PD;
+                    break;
                 case CommandType::ACTIVATE:
                 case CommandType::REFRESH:
                 case CommandType::REFRESH_BANK:
@@ -129,6 +166,9 @@ void BankState::UpdateState(const Command& cmd) {
                 case CommandType::SREF_ENTER:
                     state_ = State::SREF;
                     break;
+                case CommandType::PD_ENTER:
+                    state_ = State::PD;
+                    break;
                 case CommandType::READ:
                 case CommandType::WRITE:
                 case CommandType::READ_PRECHARGE:
@@ -158,12 +198,55 @@ void BankState::UpdateState(const Command& cmd) {
                     AbruptExit(__FILE__, __LINE__);
             }
             break;
+        case State::PD:
+            switch (cmd.cmd_type) {
+                case CommandType::PD_EXIT:
+                    state_ = open_row_ >= 0 ? State::OPEN : State::CLOSED;
+                    break;
+                default:
+                    AbruptExit(__FILE__, __LINE__);
+            }
+            break;
         default:
             AbruptExit(__FILE__, __LINE__);
     }
     return;
 }
 
+void BankState::WarmRow(int row) {
+    if (state_ == State::SREF) {
+        return;
+    }
+    if (state_ == State::PD) {
+        // stays powered down, only the row it wakes up with changes
+        row_hit_count_ = open_row_ == row ? row_hit_count_ + 1 : 0;
+        open_row_ = row;
+        return;
+    }
+    if (state_ == State::OPEN && open_row_ == row) {
+        row_hit_count_++;
+    } else {
+        state_ = State::OPEN;
+        open_row_ = row;
+        row_hit_count_ = 0;
+    }
+    return;
+}
+
+void BankState::SaveState(CheckpointWriter& out) const {
+    out.Write(state_);
+    out.Write(cmd_timing_);
+    out.Write(open_row_);
+    out.Write(row_hit_count_);
+}
+
+void BankState::LoadState(CheckpointReader& in) {
+    in.Read(state_);
+    in.Read(cmd_timing_);
+    in.Read(open_row_);
+    in.Read(row_hit_count_);
+}
+
 void BankState::UpdateTiming(CommandType cmd_type, uint64_t time) {
     cmd_timing_[static_cast<int>(cmd_type)] =
         std::max(cmd_timing_[static_cast<int>(cmd_type)], time);
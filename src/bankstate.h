@@ -6,6 +6,9 @@
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class BankState {
    public:
     BankState();
@@ -13,16 +16,29 @@ class BankState {
     enum class State { OPEN, CLOSED, SREF, PD, SIZE };
     Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
 
+    // The command this bank needs next to serve cmd, regardless of timing
+    CommandType GetRequiredType(const Command& cmd) const;
+    uint64_t EarliestIssue(CommandType cmd_type) const {
+        return cmd_timing_[static_cast<int>(cmd_type)];
+    }
+
     // Update the state of the bank resulting after the execution of the command
     void UpdateState(const Command& cmd);
 
     // Update the existing timing constraints for the command
     void UpdateTiming(const CommandType cmd_type, uint64_t time);
 
+    // Functional-only access used by fast-forwarding: open the row without
+    // any timing checks or timing updates
+    void WarmRow(int row);
+
     bool IsRowOpen() const { return state_ == State::OPEN; }
     int OpenRow() const { return open_row_; }
     int RowHitCount() const { return row_hit_count_; }
 
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
    private:
     // Current state of the Bank
     // Apriori or instantaneously transitions on a command.
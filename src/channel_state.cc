@@ -1,5 +1,6 @@
 //this is channel state.cc
 #include "channel_state.h"
+#include "checkpoint.h"
 
 namespace dramsim3 {
 ChannelState::ChannelState(const Config& config, const Timing& timing)
@@ -7,6 +8,8 @@ ChannelState::ChannelState(const Config& config, const Timing& timing)
       config_(config),
       timing_(timing),
       rank_is_sref_(config.ranks, false),
+      rank_is_pd_(config.ranks, false),
+      rank_pd_active_(config.ranks, false),
       four_aw_(config_.ranks, std::vector<uint64_t>()),
       thirty_two_aw_(config_.ranks, std::vector<uint64_t>()) {
     bank_states_.reserve(config_.ranks);
@@ -59,6 +62,15 @@ void ChannelState::BankNeedRefresh(int rank, int bankgroup, int bank,
     return;
 }
 
+bool ChannelState::IsRankRefreshWaiting(int rank) const {
+    for (const auto& ref : refresh_q_) {
+        if (ref.Rank() == rank) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void ChannelState::RankNeedRefresh(int rank, bool need) {
     if (need) {
         Address addr = Address(-1, rank, -1, -1, -1, -1);
@@ -115,8 +127,20 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
     }
 }
 
+Command ChannelState::GetRequiredCommand(const Command& cmd,
+                                         uint64_t& ready_clk) const {
+    const auto& bank_state =
+        bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()];
+    CommandType required_type = bank_state.GetRequiredType(cmd);
+    ready_clk = bank_state.EarliestIssue(required_type);
+    return Command(required_type, cmd.addr, cmd.hex_addr);
+}
+
 void ChannelState::UpdateState(const Command& cmd) {
     if (cmd.IsRankCMD()) {
+        if (cmd.cmd_type == CommandType::PD_ENTER) {
+            rank_pd_active_[cmd.Rank()] = !IsAllBankIdleInRank(cmd.Rank());
+        }
         for (auto j = 0; j < config_.bankgroups; j++) {
             for (auto k = 0; k < config_.banks_per_group; k++) {
                 bank_states_[cmd.Rank()][j][k].UpdateState(cmd);
@@ -128,6 +152,10 @@ void ChannelState::UpdateState(const Command& cmd) {
             rank_is_sref_[cmd.Rank()] = true;
         } else if (cmd.cmd_type == CommandType::SREF_EXIT) {
             rank_is_sref_[cmd.Rank()] = false;
+        } else if (cmd.cmd_type == CommandType::PD_ENTER) {
+            rank_is_pd_[cmd.Rank()] = true;
+        } else if (cmd.cmd_type == CommandType::PD_EXIT) {
+            rank_is_pd_[cmd.Rank()] = false;
         }
     } else {
         bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()].UpdateState(cmd);
@@ -176,6 +204,8 @@ void ChannelState::UpdateTiming(const Command& cmd, uint64_t clk) {
         case CommandType::REFRESH:
         case CommandType::SREF_ENTER:
         case CommandType::SREF_EXIT:
+        case CommandType::PD_ENTER:
+        case CommandType::PD_EXIT:
             UpdateSameRankTiming(
                 cmd.addr, timing_.same_rank[static_cast<int>(cmd.cmd_type)],
                 clk);
@@ -263,6 +293,40 @@ void ChannelState::UpdateSameRankTiming(
     return;
 }
 
+void ChannelState::SaveState(CheckpointWriter& out) const {
+    out.Write(rank_idle_cycles);
+    out.Write(rank_is_sref_);
+    out.Write(rank_is_pd_);
+    out.Write(rank_pd_active_);
+    for (const auto& rank_states : bank_states_) {
+        for (const auto& bg_states : rank_states) {
+            for (const auto& bank_state : bg_states) {
+                bank_state.SaveState(out);
+            }
+        }
+    }
+    out.Write(refresh_q_);
+    out.Write(four_aw_);
+    out.Write(thirty_two_aw_);
+}
+
+void ChannelState::LoadState(CheckpointReader& in) {
+    in.Read(rank_idle_cycles);
+    in.Read(rank_is_sref_);
+    in.Read(rank_is_pd_);
+    in.Read(rank_pd_active_);
+    for (auto& rank_states : bank_states_) {
+        for (auto& bg_states : rank_states) {
+            for (auto& bank_state : bg_states) {
+                bank_state.LoadState(in);
+            }
+        }
+    }
+    in.Read(refresh_q_);
+    in.Read(four_aw_);
+    in.Read(thirty_two_aw_);
+}
+
 void ChannelState::UpdateTimingAndStates(const Command& cmd, uint64_t clk) {
     UpdateState(cmd);
     UpdateTiming(cmd, clk);
@@ -9,13 +9,22 @@
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class ChannelState {
    public:
     ChannelState(const Config& config, const Timing& timing);
     Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
+    // Like GetReadyCommand but ignores timing, ready_clk is set to the
+    // earliest cycle the bank allows the returned command (tFAW not included)
+    Command GetRequiredCommand(const Command& cmd, uint64_t& ready_clk) const;
     void UpdateState(const Command& cmd);
     void UpdateTiming(const Command& cmd, uint64_t clk);
     void UpdateTimingAndStates(const Command& cmd, uint64_t clk);
+    void WarmRow(const Address& addr) {
+        bank_states_[addr.rank][addr.bankgroup][addr.bank].WarmRow(addr.row);
+    }
     bool ActivationWindowOk(int rank, uint64_t curr_time) const;
     void UpdateActivationTimes(int rank, uint64_t curr_time);
     bool IsRowOpen(int rank, int bankgroup, int bank) const {
@@ -23,7 +32,13 @@ class ChannelState {
     }
     bool IsAllBankIdleInRank(int rank) const;
     bool IsRankSelfRefreshing(int rank) const { return rank_is_sref_[rank]; }
+    bool IsRankPoweredDown(int rank) const { return rank_is_pd_[rank]; }
+    // powered down with rows left open (active power-down)
+    bool IsRankActivePowerDown(int rank) const {
+        return rank_is_pd_[rank] && rank_pd_active_[rank];
+    }
     bool IsRefreshWaiting() const { return !refresh_q_.empty(); }
+    bool IsRankRefreshWaiting(int rank) const;
     bool IsRWPendingOnRef(const Command& cmd) const;
     const Command& PendingRefCommand() const {return refresh_q_.front(); }
     void BankNeedRefresh(int rank, int bankgroup, int bank, bool need);
@@ -35,6 +50,9 @@ class ChannelState {
         return bank_states_[rank][bankgroup][bank].RowHitCount();
     };
 
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
     std::vector<int> rank_idle_cycles;
 
    private:
@@ -42,6 +60,8 @@ class ChannelState {
     const Timing& timing_;
 
     std::vector<bool> rank_is_sref_;
+    std::vector<bool> rank_is_pd_;
+    std::vector<bool> rank_pd_active_;
     std::vector<std::vector<std::vector<BankState> > > bank_states_;
     std::vector<Command> refresh_q_;
 
@@ -0,0 +1,181 @@
+#include "checkpoint.h"
+
+#include <cstring>
+
+namespace dramsim3 {
+
+namespace {
+const char kCheckpointMagic[8] = {'D', 'S', '3', 'C', 'K', 'P', 'T', '\0'};
+
+// the organization a checkpoint is only valid for, anything that changes
+// the shape of the queues or bank state arrays goes in here
+std::vector<int> ConfigFingerprint(const Config& config) {
+    return {static_cast<int>(config.protocol),
+            config.channels,
+            config.ranks,
+            config.bankgroups,
+            config.banks_per_group,
+            config.rows,
+            config.columns,
+            config.bus_width,
+            config.BL,
+            config.trans_queue_size,
+            config.write_buf_size,
+            config.cmd_queue_size,
+            config.unified_queue ? 1 : 0,
+            static_cast<int>(config.refresh_policy)};
+}
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(const std::string& file_name)
+    : out_(file_name, std::ofstream::out | std::ofstream::binary) {}
+
+void CheckpointWriter::WriteHeader(const Config& config) {
+    out_.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+    Write(kCheckpointVersion);
+    Write(ConfigFingerprint(config));
+    Write(config.queue_structure);
+    Write(config.address_mapping);
+    Write(config.address_hash);
+}
+
+void CheckpointWriter::Write(const std::string& str) {
+    Write(static_cast<uint64_t>(str.size()));
+    out_.write(str.data(), str.size());
+}
+
+void CheckpointWriter::Write(const Address& addr) {
+    Write(addr.channel);
+    Write(addr.rank);
+    Write(addr.bankgroup);
+    Write(addr.bank);
+    Write(addr.row);
+    Write(addr.column);
+}
+
+void CheckpointWriter::Write(const Command& cmd) {
+    Write(cmd.cmd_type);
+    Write(cmd.addr);
+    Write(cmd.hex_addr);
+    Write(cmd.source);
+    Write(cmd.added_cycle);
+    Write(cmd.marked);
+}
+
+void CheckpointWriter::Write(const Transaction& trans) {
+    Write(trans.addr);
+    Write(trans.added_cycle);
+    Write(trans.scheduled_cycle);
+    Write(trans.act_cycle);
+    Write(trans.column_cycle);
+    Write(trans.complete_cycle);
+    Write(trans.source);
+    Write(trans.is_write);
+    Write(trans.size);
+    Write(trans.parent_id);
+    Write(trans.request_id);
+}
+
+void CheckpointWriter::Write(const std::vector<bool>& vec) {
+    Write(static_cast<uint64_t>(vec.size()));
+    for (size_t i = 0; i < vec.size(); i++) {
+        Write(static_cast<bool>(vec[i]));
+    }
+}
+
+CheckpointReader::CheckpointReader(const std::string& file_name)
+    : in_(file_name, std::ifstream::in | std::ifstream::binary) {}
+
+bool CheckpointReader::ReadHeader(const Config& config) {
+    char magic[sizeof(kCheckpointMagic)];
+    in_.read(magic, sizeof(magic));
+    if (!in_.good() || std::memcmp(magic, kCheckpointMagic, sizeof(magic))) {
+        std::cerr << "Not a DRAMsim3 checkpoint file!" << std::endl;
+        return false;
+    }
+    uint32_t version;
+    Read(version);
+    if (version != kCheckpointVersion) {
+        std::cerr << "Checkpoint version " << version
+                  << " does not match simulator version "
+                  << kCheckpointVersion << std::endl;
+        return false;
+    }
+    std::vector<int> fingerprint;
+    std::string queue_structure, address_mapping, address_hash;
+    Read(fingerprint);
+    Read(queue_structure);
+    Read(address_mapping);
+    Read(address_hash);
+    if (fingerprint != ConfigFingerprint(config) ||
+        queue_structure != config.queue_structure ||
+        address_mapping != config.address_mapping ||
+        address_hash != config.address_hash) {
+        std::cerr << "Checkpoint was taken with a different DRAM organization!"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void CheckpointReader::Read(std::string& str) {
+    uint64_t size;
+    Read(size);
+    str.resize(size);
+    in_.read(&str[0], size);
+    CheckStream();
+}
+
+void CheckpointReader::Read(Address& addr) {
+    Read(addr.channel);
+    Read(addr.rank);
+    Read(addr.bankgroup);
+    Read(addr.bank);
+    Read(addr.row);
+    Read(addr.column);
+}
+
+void CheckpointReader::Read(Command& cmd) {
+    Read(cmd.cmd_type);
+    Read(cmd.addr);
+    Read(cmd.hex_addr);
+    Read(cmd.source);
+    Read(cmd.added_cycle);
+    Read(cmd.marked);
+}
+
+void CheckpointReader::Read(Transaction& trans) {
+    Read(trans.addr);
+    Read(trans.added_cycle);
+    Read(trans.scheduled_cycle);
+    Read(trans.act_cycle);
+    Read(trans.column_cycle);
+    Read(trans.complete_cycle);
+    Read(trans.source);
+    Read(trans.is_write);
+    Read(trans.size);
+    Read(trans.parent_id);
+    Read(trans.request_id);
+}
+
+void CheckpointReader::Read(std::vector<bool>& vec) {
+    uint64_t size;
+    Read(size);
+    vec.assign(size, false);
+    for (uint64_t i = 0; i < size; i++) {
+        bool val;
+        Read(val);
+        vec[i] = val;
+    }
+}
+
+void CheckpointReader::CheckStream() {
+    // once we are past the header the simulator state has been partially
+    // overwritten, there is no sane way to continue
+    if (!in_.good()) {
+        std::cerr << "Checkpoint file is truncated or corrupted!" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,174 @@
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// Bump this whenever the layout of any SaveState/LoadState changes so that
+// stale checkpoints are rejected instead of silently misread
+const uint32_t kCheckpointVersion = 18;
+
+// Compact binary serializer for simulator state. Every stateful class
+// implements SaveState/LoadState in terms of these primitives and the
+// reader has to consume fields in exactly the order they were written.
+class CheckpointWriter {
+   public:
+    explicit CheckpointWriter(const std::string& file_name);
+    bool IsGood() const { return out_.good(); }
+    void WriteHeader(const Config& config);
+
+    template <typename T>
+    void Write(const T& val) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "only plain values can be written directly");
+        out_.write(reinterpret_cast<const char*>(&val), sizeof(T));
+    }
+    void Write(const std::string& str);
+    void Write(const Address& addr);
+    void Write(const Command& cmd);
+    void Write(const Transaction& trans);
+
+    template <typename A, typename B>
+    void Write(const std::pair<A, B>& pair) {
+        Write(pair.first);
+        Write(pair.second);
+    }
+
+    template <typename T>
+    void Write(const std::vector<T>& vec) {
+        Write(static_cast<uint64_t>(vec.size()));
+        for (const auto& val : vec) {
+            Write(static_cast<const T&>(val));
+        }
+    }
+    void Write(const std::vector<bool>& vec);
+
+    template <typename K, typename V>
+    void Write(const std::unordered_map<K, V>& map) {
+        Write(static_cast<uint64_t>(map.size()));
+        for (const auto& it : map) {
+            Write(it.first);
+            Write(it.second);
+        }
+    }
+
+    template <typename K, typename V>
+    void Write(const std::multimap<K, V>& map) {
+        Write(static_cast<uint64_t>(map.size()));
+        for (const auto& it : map) {
+            Write(it.first);
+            Write(it.second);
+        }
+    }
+
+    template <typename T>
+    void Write(const std::unordered_set<T>& set) {
+        Write(static_cast<uint64_t>(set.size()));
+        for (const auto& val : set) {
+            Write(val);
+        }
+    }
+
+   private:
+    std::ofstream out_;
+};
+
+class CheckpointReader {
+   public:
+    explicit CheckpointReader(const std::string& file_name);
+    bool IsGood() const { return in_.good(); }
+    // returns false if the file was written by an incompatible version or
+    // with a different DRAM organization
+    bool ReadHeader(const Config& config);
+
+    template <typename T>
+    void Read(T& val) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                      "only plain values can be read directly");
+        in_.read(reinterpret_cast<char*>(&val), sizeof(T));
+        CheckStream();
+    }
+    void Read(std::string& str);
+    void Read(Address& addr);
+    void Read(Command& cmd);
+    void Read(Transaction& trans);
+
+    template <typename A, typename B>
+    void Read(std::pair<A, B>& pair) {
+        Read(pair.first);
+        Read(pair.second);
+    }
+
+    template <typename T>
+    void Read(std::vector<T>& vec) {
+        uint64_t size;
+        Read(size);
+        // clear() instead of reassigning keeps the reserved capacity,
+        // which some queues use as their size limit
+        vec.clear();
+        for (uint64_t i = 0; i < size; i++) {
+            T val;
+            Read(val);
+            vec.push_back(val);
+        }
+    }
+    void Read(std::vector<bool>& vec);
+
+    template <typename K, typename V>
+    void Read(std::unordered_map<K, V>& map) {
+        uint64_t size;
+        Read(size);
+        map.clear();
+        for (uint64_t i = 0; i < size; i++) {
+            K key;
+            V val;
+            Read(key);
+            Read(val);
+            map[key] = val;
+        }
+    }
+
+    template <typename K, typename V>
+    void Read(std::multimap<K, V>& map) {
+        uint64_t size;
+        Read(size);
+        map.clear();
+        for (uint64_t i = 0; i < size; i++) {
+            K key;
+            V val;
+            Read(key);
+            Read(val);
+            map.insert(std::make_pair(key, val));
+        }
+    }
+
+    template <typename T>
+    void Read(std::unordered_set<T>& set) {
+        uint64_t size;
+        Read(size);
+        set.clear();
+        for (uint64_t i = 0; i < size; i++) {
+            T val;
+            Read(val);
+            set.insert(val);
+        }
+    }
+
+   private:
+    std::ifstream in_;
+    void CheckStream();
+};
+
+}  // namespace dramsim3
+#endif
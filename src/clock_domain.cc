@@ -0,0 +1,86 @@
+#include "clock_domain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "checkpoint.h"
+#include "common.h"
+
+namespace dramsim3 {
+
+namespace {
+uint64_t GCD(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+const uint64_t kFSPerMS = 1000000000000ULL;
+}  // namespace
+
+ClockDomainCrosser::ClockDomainCrosser(uint64_t parent_period,
+                                       uint64_t child_period)
+    : residue_(0) {
+    SetPeriods(parent_period, child_period);
+}
+
+void ClockDomainCrosser::SetPeriods(uint64_t parent_period,
+                                    uint64_t child_period) {
+    if (parent_period == 0 || child_period == 0) {
+        std::cerr << "Clock period cannot be zero!" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    uint64_t gcd = GCD(parent_period, child_period);
+    parent_period_ = parent_period / gcd;
+    child_period_ = child_period / gcd;
+    residue_ = 0;
+    return;
+}
+
+void ClockDomainCrosser::SetClocks(double parent_freq_mhz,
+                                   double child_tck_ns) {
+    uint64_t parent_khz =
+        static_cast<uint64_t>(std::llround(parent_freq_mhz * 1000.0));
+    uint64_t child_fs =
+        static_cast<uint64_t>(std::llround(child_tck_ns * 1000000.0));
+    // the parent period is kFSPerMS / parent_khz fs, both are scaled by
+    // parent_khz so that neither has to be rounded
+    SetPeriods(kFSPerMS, child_fs * parent_khz);
+}
+
+uint64_t ClockDomainCrosser::AdvanceParent(uint64_t parent_cycles) {
+    // the common 1:1 case should not pay for a division
+    if (parent_period_ == child_period_) {
+        return parent_cycles;
+    }
+    // large batches are split so that the accumulator cannot overflow
+    uint64_t max_step =
+        (std::numeric_limits<uint64_t>::max() - child_period_) /
+        parent_period_;
+    uint64_t child_cycles = 0;
+    while (parent_cycles > 0) {
+        uint64_t step = std::min(parent_cycles, max_step);
+        residue_ += step * parent_period_;
+        child_cycles += residue_ / child_period_;
+        residue_ %= child_period_;
+        parent_cycles -= step;
+    }
+    return child_cycles;
+}
+
+void ClockDomainCrosser::SaveState(CheckpointWriter& out) const {
+    out.Write(parent_period_);
+    out.Write(child_period_);
+    out.Write(residue_);
+}
+
+void ClockDomainCrosser::LoadState(CheckpointReader& in) {
+    in.Read(parent_period_);
+    in.Read(child_period_);
+    in.Read(residue_);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,39 @@
+#ifndef __CLOCK_DOMAIN_H
+#define __CLOCK_DOMAIN_H
+
+#include <stdint.h>
+
+namespace dramsim3 {
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Converts cycles of a parent (e.g. CPU) clock domain into the number of
+// cycles a child (e.g. DRAM) clock domain has to advance. The two periods
+// are kept as an exact integer ratio reduced by their gcd and only the
+// leftover parent time is carried over, so non-integer ratios do not drift
+// and the accumulator never overflows.
+class ClockDomainCrosser {
+   public:
+    // periods in any common unit
+    ClockDomainCrosser(uint64_t parent_period, uint64_t child_period);
+    // advance the parent domain by a number of cycles, return how many
+    // child cycles are due as a result
+    uint64_t AdvanceParent(uint64_t parent_cycles);
+    void SetPeriods(uint64_t parent_period, uint64_t child_period);
+    // parent frequency in MHz and child tCK in ns, exact up to kHz and fs
+    void SetClocks(double parent_freq_mhz, double child_tck_ns);
+    uint64_t ParentPeriod() const { return parent_period_; }
+    uint64_t ChildPeriod() const { return child_period_; }
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
+   private:
+    uint64_t parent_period_;
+    uint64_t child_period_;
+    // parent time not yet consumed by a full child cycle
+    uint64_t residue_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,129 @@
+#include "cmd_trace.h"
+
+#include <cstring>
+
+namespace dramsim3 {
+
+namespace {
+const char kCmdTraceMagic[8] = {'D', 'S', '3', 'C', 'M', 'D', 'T', '\0'};
+
+// 1.5MB per buffer
+const size_t kCmdTraceBufferRecords = 1 << 16;
+}  // namespace
+
+CmdTraceWriter::CmdTraceWriter() : has_pending_(false), stop_(false) {}
+
+CmdTraceWriter::~CmdTraceWriter() { Close(); }
+
+void CmdTraceWriter::Open(const std::string& file_name) {
+    out_.open(file_name, std::ofstream::out | std::ofstream::binary);
+    if (!out_) {
+        std::cerr << "Cannot open command trace " << file_name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    uint32_t record_size = sizeof(CmdTraceRecord);
+    out_.write(kCmdTraceMagic, sizeof(kCmdTraceMagic));
+    out_.write(reinterpret_cast<const char*>(&kCmdTraceVersion),
+               sizeof(kCmdTraceVersion));
+    out_.write(reinterpret_cast<const char*>(&record_size),
+               sizeof(record_size));
+    active_.reserve(kCmdTraceBufferRecords);
+    pending_.reserve(kCmdTraceBufferRecords);
+    stop_ = false;
+    worker_ = std::thread(&CmdTraceWriter::WorkerLoop, this);
+}
+
+void CmdTraceWriter::Write(uint64_t clk, const Command& cmd) {
+    CmdTraceRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.clk = clk;
+    record.row = cmd.Row();
+    record.column = cmd.Column();
+    record.cmd_type = static_cast<uint8_t>(cmd.cmd_type);
+    record.channel = cmd.Channel();
+    record.rank = cmd.Rank();
+    record.bankgroup = cmd.Bankgroup();
+    record.bank = cmd.Bank();
+    active_.push_back(record);
+    if (active_.size() >= kCmdTraceBufferRecords) {
+        Handoff();
+    }
+}
+
+void CmdTraceWriter::Handoff() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // only blocks if the disk cannot keep up with a whole buffer
+    cv_.wait(lock, [this] { return !has_pending_; });
+    active_.swap(pending_);
+    has_pending_ = true;
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void CmdTraceWriter::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this] { return has_pending_ || stop_; });
+        if (has_pending_) {
+            // the simulation thread does not touch pending_ until it is
+            // handed back
+            lock.unlock();
+            out_.write(reinterpret_cast<const char*>(pending_.data()),
+                       pending_.size() * sizeof(CmdTraceRecord));
+            pending_.clear();
+            lock.lock();
+            has_pending_ = false;
+            cv_.notify_all();
+        } else {
+            return;
+        }
+    }
+}
+
+void CmdTraceWriter::Close() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    if (!active_.empty()) {
+        Handoff();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+    out_.close();
+}
+
+CmdTraceReader::CmdTraceReader(const std::string& file_name)
+    : in_(file_name, std::ifstream::in | std::ifstream::binary),
+      valid_(false) {
+    char magic[sizeof(kCmdTraceMagic)];
+    uint32_t version = 0, record_size = 0;
+    in_.read(magic, sizeof(magic));
+    in_.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in_.read(reinterpret_cast<char*>(&record_size), sizeof(record_size));
+    valid_ = in_.good() &&
+             std::memcmp(magic, kCmdTraceMagic, sizeof(magic)) == 0 &&
+             version == kCmdTraceVersion &&
+             record_size == sizeof(CmdTraceRecord);
+}
+
+bool CmdTraceReader::Next(uint64_t& clk, Command& cmd) {
+    if (!valid_) {
+        return false;
+    }
+    CmdTraceRecord record;
+    if (!in_.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+        return false;
+    }
+    clk = record.clk;
+    cmd.cmd_type = static_cast<CommandType>(record.cmd_type);
+    cmd.addr = Address(record.channel, record.rank, record.bankgroup,
+                       record.bank, record.row, record.column);
+    cmd.hex_addr = 0;
+    return true;
+}
+
+}  // namespace dramsim3
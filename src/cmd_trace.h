@@ -0,0 +1,73 @@
+#ifndef __CMD_TRACE_H
+#define __CMD_TRACE_H
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common.h"
+
+namespace dramsim3 {
+
+// One issued command, fixed width so traces can be read back without
+// parsing. The file starts with an 8 byte magic, a version and the record
+// size, followed by records in issue order. Address fields are signed,
+// commands to a whole rank or bankgroup carry -1 like Address does.
+struct CmdTraceRecord {
+    uint64_t clk;
+    int32_t row;
+    int32_t column;
+    uint8_t cmd_type;
+    int8_t channel;
+    int8_t rank;
+    int8_t bankgroup;
+    int8_t bank;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(CmdTraceRecord) == 24, "trace records must be packed");
+
+const uint32_t kCmdTraceVersion = 1;
+
+// Records are collected in one buffer while a background thread writes
+// the other one out, so tracing costs a copy per command on the simulation
+// thread and no flush per line.
+class CmdTraceWriter {
+   public:
+    CmdTraceWriter();
+    ~CmdTraceWriter();
+    void Open(const std::string& file_name);
+    void Write(uint64_t clk, const Command& cmd);
+    // write out what is buffered and stop the background thread
+    void Close();
+
+   private:
+    std::ofstream out_;
+    std::vector<CmdTraceRecord> active_;
+    std::vector<CmdTraceRecord> pending_;
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool has_pending_;
+    bool stop_;
+
+    void Handoff();
+    void WorkerLoop();
+};
+
+class CmdTraceReader {
+   public:
+    explicit CmdTraceReader(const std::string& file_name);
+    // false if the file does not exist or is not a binary command trace
+    bool IsValid() const { return valid_; }
+    bool Next(uint64_t& clk, Command& cmd);
+
+   private:
+    std::ifstream in_;
+    bool valid_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,42 @@
+// Converts binary command traces back to the text format, e.g. for
+// scripts/validation.py
+#include <iomanip>
+#include <iostream>
+#include "./../ext/headers/args.hxx"
+#include "cmd_trace.h"
+
+using namespace dramsim3;
+
+int main(int argc, const char **argv) {
+    args::ArgumentParser parser("Command trace decoder.",
+                                "Example: \n"
+                                "./build/dramsim3cmdtrace ch_0cmd.bin > "
+                                "cmd.trace");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::Positional<std::string> trace_arg(parser, "trace",
+                                            "Binary command trace");
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string trace_file = args::get(trace_arg);
+    CmdTraceReader reader(trace_file);
+    if (!reader.IsValid()) {
+        std::cerr << trace_file << " is not a binary command trace"
+                  << std::endl;
+        return 1;
+    }
+    uint64_t clk;
+    Command cmd;
+    while (reader.Next(clk, cmd)) {
+        std::cout << std::left << std::setw(18) << clk << " " << cmd << "\n";
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 //this is command queue.cc
 #include "command_queue.h"
+#include "checkpoint.h"
 
 namespace dramsim3 {
 
@@ -10,10 +11,14 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
       config_(config),
       channel_state_(channel_state),
       simple_stats_(simple_stats),
+      scheduler_(MakeScheduler(config)),
       is_in_ref_(false),
       queue_size_(static_cast<size_t>(config_.cmd_queue_size)),
       queue_idx_(0),
-      clk_(0) {
+      clk_(0),
+      bankgroup_interleave_(config.bankgroup_interleave),
+      last_col_rank_(-1),
+      last_col_bankgroup_(-1) {
     if (config_.queue_structure == "PER_BANK") {
         queue_structure_ = QueueStructure::PER_BANK;
         num_queues_ = config_.banks * config_.ranks;
@@ -35,6 +40,10 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
 }
 
 Command CommandQueue::GetCommandToIssue() {
+    // with bankgroup interleaving the round robin pick can be passed over
+    // for a column command that switches bankgroups
+    Command first;
+    int first_idx = queue_idx_;
     for (int i = 0; i < num_queues_; i++) {
         auto& queue = GetNextQueue();
         // if we're refresing, skip the command queues that are involved
@@ -44,16 +53,42 @@ Command CommandQueue::GetCommandToIssue() {
             }
         }
         auto cmd = GetFirstReadyInQueue(queue);
-        if (cmd.IsValid()) {
-            if (cmd.IsReadWrite()) {
-                EraseRWCommand(cmd);
+        if (!cmd.IsValid()) {
+            continue;
+        }
+        if (!bankgroup_interleave_ || SwitchesBankgroup(cmd)) {
+            if (first.IsValid()) {
+                simple_stats_.Increment("num_bankgroup_reorders");
             }
-            return cmd;
+            return IssueFromQueue(cmd);
         }
+        if (!first.IsValid()) {
+            first = cmd;
+            first_idx = queue_idx_;
+        }
+    }
+    if (first.IsValid()) {
+        queue_idx_ = first_idx;
+        return IssueFromQueue(first);
     }
     return Command();
 }
 
+Command CommandQueue::IssueFromQueue(const Command& cmd) {
+    if (cmd.IsReadWrite()) {
+        EraseRWCommand(cmd);
+        if (cmd.Rank() == last_col_rank_) {
+            simple_stats_.Increment(cmd.Bankgroup() == last_col_bankgroup_
+                                        ? "num_same_bankgroup_cols"
+                                        : "num_diff_bankgroup_cols");
+        }
+        last_col_rank_ = cmd.Rank();
+        last_col_bankgroup_ = cmd.Bankgroup();
+    }
+    scheduler_->CommandIssued(cmd, clk_);
+    return cmd;
+}
+
 Command CommandQueue::FinishRefresh() {
     // we can do something fancy here like clearing the R/Ws
     // that already had ACT on the way but by doing that we
@@ -100,10 +135,9 @@ bool CommandQueue::ArbitratePrecharge(const CMDIterator& cmd_it,
         }
     }
 
-    bool rowhit_limit_reached =
-        channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()) >=
-        4;
-    if (!pending_row_hits_exist || rowhit_limit_reached) {
+    bool hold_for_row_hits = scheduler_->HoldPrecharge(
+        channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
+    if (!pending_row_hits_exist || !hold_for_row_hits) {
         simple_stats_.Increment("num_ondemand_pres");
         return true;
     }
@@ -116,7 +150,7 @@ bool CommandQueue::WillAcceptCommand(int rank, int bankgroup, int bank) const {
 }
 
 bool CommandQueue::QueueEmpty() const {
-    for (const auto q : queues_) {
+    for (const auto& q : queues_) {
         if (!q.empty()) {
             return false;
         }
@@ -124,10 +158,39 @@ bool CommandQueue::QueueEmpty() const {
     return true;
 }
 
+bool CommandQueue::BankEmpty(int rank, int bankgroup, int bank) const {
+    const auto& queue = queues_[GetQueueIndex(rank, bankgroup, bank)];
+    for (const auto& cmd : queue) {
+        if (cmd.Rank() == rank && cmd.Bankgroup() == bankgroup &&
+            cmd.Bank() == bank) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommandQueue::RankEmpty(int rank) const {
+    int first = GetQueueIndex(rank, 0, 0);
+    int last = queue_structure_ == QueueStructure::PER_RANK
+                   ? first + 1
+                   : first + config_.banks;
+    for (int i = first; i < last; i++) {
+        if (!queues_[i].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CommandQueue::ClockTick() {
+    clk_ += 1;
+    scheduler_->ClockTick(queues_, clk_);
+}
 
 bool CommandQueue::AddCommand(Command cmd) {
     auto& queue = GetQueue(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
     if (queue.size() < queue_size_) {
+        cmd.added_cycle = clk_;
         queue.push_back(cmd);
         rank_q_empty[cmd.Rank()] = false;
         return true;
@@ -177,7 +240,13 @@ CMDQueue& CommandQueue::GetQueue(int rank, int bankgroup, int bank) {
 }
 
 Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) const {
+    Command best;
+    uint64_t best_priority = 0;
+    uint64_t max_priority = scheduler_->MaxPriority();
     for (auto cmd_it = queue.begin(); cmd_it != queue.end(); cmd_it++) {
+        if (!scheduler_->IsEligible(queue, cmd_it - queue.begin())) {
+            continue;
+        }
         Command cmd = channel_state_.GetReadyCommand(*cmd_it, clk_);
         if (!cmd.IsValid()) {
             continue;
@@ -191,9 +260,25 @@ Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) const {
                 continue;
             }
         }
-        return cmd;
+        cmd.source = cmd_it->source;
+        cmd.added_cycle = cmd_it->added_cycle;
+        cmd.marked = cmd_it->marked;
+        // ties go to the older command, or to the one that switches
+        // bankgroups when interleaving
+        uint64_t priority = scheduler_->Priority(*cmd_it, cmd);
+        if (!best.IsValid() || priority > best_priority) {
+            best = cmd;
+            best_priority = priority;
+        } else if (bankgroup_interleave_ && priority == best_priority &&
+                   SwitchesBankgroup(cmd) && !SwitchesBankgroup(best)) {
+            best = cmd;
+        }
+        if (best_priority >= max_priority &&
+            (!bankgroup_interleave_ || SwitchesBankgroup(best))) {
+            break;
+        }
     }
-    return Command();
+    return best;
 }
 
 void CommandQueue::EraseRWCommand(const Command& cmd) {
@@ -216,6 +301,30 @@ int CommandQueue::QueueUsage() const {
     return usage;
 }
 
+void CommandQueue::SaveState(CheckpointWriter& out) const {
+    out.Write(rank_q_empty);
+    out.Write(queues_);
+    out.Write(ref_q_indices_);
+    out.Write(is_in_ref_);
+    out.Write(queue_idx_);
+    out.Write(clk_);
+    out.Write(last_col_rank_);
+    out.Write(last_col_bankgroup_);
+    scheduler_->SaveState(out);
+}
+
+void CommandQueue::LoadState(CheckpointReader& in) {
+    in.Read(rank_q_empty);
+    in.Read(queues_);
+    in.Read(ref_q_indices_);
+    in.Read(is_in_ref_);
+    in.Read(queue_idx_);
+    in.Read(clk_);
+    in.Read(last_col_rank_);
+    in.Read(last_col_bankgroup_);
+    scheduler_->LoadState(in);
+}
+
 bool CommandQueue::HasRWDependency(const CMDIterator& cmd_it,
                                    const CMDQueue& queue) const {
     // Read after write has been checked in controller so we only
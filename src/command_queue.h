@@ -1,17 +1,21 @@
 #ifndef __COMMAND_QUEUE_H
 #define __COMMAND_QUEUE_H
 
+#include <memory>
 #include <unordered_set>
 #include <vector>
 #include "channel_state.h"
 #include "common.h"
 #include "configuration.h"
+#include "scheduler.h"
 #include "simple_stats.h"
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 using CMDIterator = std::vector<Command>::iterator;
-using CMDQueue = std::vector<Command>;
 enum class QueueStructure { PER_RANK, PER_BANK, SIZE };
 
 class CommandQueue {
@@ -20,11 +24,17 @@ class CommandQueue {
                  const ChannelState& channel_state, SimpleStats& simple_stats);
     Command GetCommandToIssue();
     Command FinishRefresh();
-    void ClockTick() { clk_ += 1; };
+    void ClockTick();
+    void FastForward(uint64_t cycles) { clk_ += cycles; }
     bool WillAcceptCommand(int rank, int bankgroup, int bank) const;
     bool AddCommand(Command cmd);
     bool QueueEmpty() const;
+    bool BankEmpty(int rank, int bankgroup, int bank) const;
+    bool RankEmpty(int rank) const;
     int QueueUsage() const;
+    const std::vector<CMDQueue>& GetQueues() const { return queues_; }
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
     std::vector<bool> rank_q_empty;
 
    private:
@@ -39,11 +49,17 @@ class CommandQueue {
     void GetRefQIndices(const Command& ref);
     void EraseRWCommand(const Command& cmd);
     Command PrepRefCmd(const CMDIterator& it, const Command& ref) const;
+    Command IssueFromQueue(const Command& cmd);
+    bool SwitchesBankgroup(const Command& cmd) const {
+        return cmd.IsReadWrite() && cmd.Rank() == last_col_rank_ &&
+               cmd.Bankgroup() != last_col_bankgroup_;
+    }
 
     QueueStructure queue_structure_;
     const Config& config_;
     const ChannelState& channel_state_;
     SimpleStats& simple_stats_;
+    std::unique_ptr<Scheduler> scheduler_;
 
     std::vector<CMDQueue> queues_;
 
@@ -55,6 +71,11 @@ class CommandQueue {
     size_t queue_size_;
     int queue_idx_;
     uint64_t clk_;
+
+    // bankgroup aware arbitration and where the last column command went
+    bool bankgroup_interleave_;
+    int last_col_rank_;
+    int last_col_bankgroup_;
 };
 
 }  // namespace dramsim3
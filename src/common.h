@@ -62,13 +62,25 @@ enum class CommandType {
     REFRESH,
     SREF_ENTER,
     SREF_EXIT,
+    PD_ENTER,
+    PD_EXIT,
     SIZE
 };
 
 struct Command {
-    Command() : cmd_type(CommandType::SIZE), hex_addr(0) {}
+    Command()
+        : cmd_type(CommandType::SIZE),
+          hex_addr(0),
+          source(0),
+          added_cycle(0),
+          marked(false) {}
     Command(CommandType cmd_type, const Address& addr, uint64_t hex_addr)
-        : cmd_type(cmd_type), addr(addr), hex_addr(hex_addr) {}
+        : cmd_type(cmd_type),
+          addr(addr),
+          hex_addr(hex_addr),
+          source(0),
+          added_cycle(0),
+          marked(false) {}
     // Command(const Command& cmd) {}
 
     bool IsValid() const { return cmd_type != CommandType::SIZE; }
@@ -88,11 +100,18 @@ struct Command {
     bool IsRankCMD() const {
         return cmd_type == CommandType::REFRESH ||
                cmd_type == CommandType::SREF_ENTER ||
-               cmd_type == CommandType::SREF_EXIT;
+               cmd_type == CommandType::SREF_EXIT ||
+               cmd_type == CommandType::PD_ENTER ||
+               cmd_type == CommandType::PD_EXIT;
     }
     CommandType cmd_type;
     Address addr;
     uint64_t hex_addr;
+    // requester and cycle it entered the command queue, for scheduling
+    uint32_t source;
+    uint64_t added_cycle;
+    // part of the current PAR-BS batch
+    bool marked;
 
     int Channel() const { return addr.channel; }
     int Rank() const { return addr.rank; }
@@ -109,17 +128,45 @@ struct Transaction {
     Transaction(uint64_t addr, bool is_write)
         : addr(addr),
           added_cycle(0),
+          scheduled_cycle(0),
+          act_cycle(0),
+          column_cycle(0),
           complete_cycle(0),
-          is_write(is_write) {}
+          source(0),
+          is_write(is_write),
+          size(0),
+          parent_id(0),
+          request_id(0) {}
     Transaction(const Transaction& tran)
         : addr(tran.addr),
           added_cycle(tran.added_cycle),
+          scheduled_cycle(tran.scheduled_cycle),
+          act_cycle(tran.act_cycle),
+          column_cycle(tran.column_cycle),
           complete_cycle(tran.complete_cycle),
-          is_write(tran.is_write) {}
+          source(tran.source),
+          is_write(tran.is_write),
+          size(tran.size),
+          parent_id(tran.parent_id),
+          request_id(tran.request_id) {}
     uint64_t addr;
+    // stage timestamps: entered the transaction queue, moved to the command
+    // queue, its ACT was issued (0 on a row hit), READ/WRITE was issued and
+    // data is returned
     uint64_t added_cycle;
+    uint64_t scheduled_cycle;
+    uint64_t act_cycle;
+    uint64_t column_cycle;
     uint64_t complete_cycle;
+    uint32_t source;
     bool is_write;
+    // bytes, 0 is one burst. A request spanning several bursts is queued as
+    // one part per burst and the parts carry the id of their request
+    uint32_t size;
+    uint64_t parent_id;
+    // a request split over channels carries the id the memory system tracks
+    // it by until every channel has returned it, 0 otherwise
+    uint64_t request_id;
 
     friend std::ostream& operator<<(std::ostream& os, const Transaction& trans);
     friend std::istream& operator>>(std::istream& is, Transaction& trans);
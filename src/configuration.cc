@@ -1,6 +1,9 @@
 #include "configuration.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
+#include <unistd.h>
 
 #ifdef THERMAL
 #include <math.h>
@@ -8,8 +11,59 @@
 
 namespace dramsim3 {
 
+namespace {
+// INIReader concatenates duplicated keys, so overrides have to replace the
+// parsed values directly
+class OverrideINIReader : public INIReader {
+   public:
+    OverrideINIReader(const std::string& config_file,
+                      const std::map<std::string, std::string>& overrides)
+        : INIReader(config_file) {
+        for (const auto& it : overrides) {
+            auto dot = it.first.find('.');
+            if (dot == std::string::npos) {
+                std::cerr << "Config override " << it.first
+                          << " is not in section.key format!" << std::endl;
+                AbruptExit(__FILE__, __LINE__);
+            }
+            std::string section = it.first.substr(0, dot);
+            std::string name = it.first.substr(dot + 1);
+            _values[MakeKey(section, name)] = it.second;
+            _sections.insert(section);
+        }
+    }
+};
+
+// rank over GF(2) of the address bit masks, full rank means no two addresses
+// map to the same location
+int GF2Rank(std::vector<uint64_t> rows) {
+    int rank = 0;
+    for (int bit = 0; bit < 64; bit++) {
+        uint64_t pivot_bit = 1ULL << bit;
+        for (size_t i = rank; i < rows.size(); i++) {
+            if (rows[i] & pivot_bit) {
+                std::swap(rows[i], rows[rank]);
+                for (size_t j = 0; j < rows.size(); j++) {
+                    if (j != static_cast<size_t>(rank) && (rows[j] & pivot_bit)) {
+                        rows[j] ^= rows[rank];
+                    }
+                }
+                rank++;
+                break;
+            }
+        }
+    }
+    return rank;
+}
+}  // namespace
+
 Config::Config(std::string config_file, std::string out_dir)
-    : output_dir(out_dir), reader_(new INIReader(config_file)) {
+    : Config(config_file, out_dir, std::map<std::string, std::string>()) {}
+
+Config::Config(std::string config_file, std::string out_dir,
+               const std::map<std::string, std::string>& overrides)
+    : output_dir(out_dir),
+      reader_(new OverrideINIReader(config_file, overrides)) {
     if (reader_->ParseError() < 0) {
         std::cerr << "Can't load config file - " << config_file << std::endl;
         AbruptExit(__FILE__, __LINE__);
@@ -32,15 +86,43 @@ Config::Config(std::string config_file, std::string out_dir)
 
 Address Config::AddressMapping(uint64_t hex_addr) const {
     hex_addr >>= shift_bits;
-    int channel = (hex_addr >> ch_pos) & ch_mask;
-    int rank = (hex_addr >> ra_pos) & ra_mask;
-    int bg = (hex_addr >> bg_pos) & bg_mask;
-    int ba = (hex_addr >> ba_pos) & ba_mask;
+    // only channel, rank, bankgroup and bank can be hashed
+    uint64_t field_addr = hash_table_.empty() ? hex_addr : HashFields(hex_addr);
+    int channel = (field_addr >> ch_pos) & ch_mask;
+    int rank = (field_addr >> ra_pos) & ra_mask;
+    int bg = (field_addr >> bg_pos) & bg_mask;
+    int ba = (field_addr >> ba_pos) & ba_mask;
     int ro = (hex_addr >> ro_pos) & ro_mask;
     int co = (hex_addr >> co_pos) & co_mask;
     return Address(channel, rank, bg, ba, ro, co);
 }
 
+int Config::Channel(uint64_t hex_addr) const {
+    hex_addr >>= shift_bits;
+    uint64_t field_addr = hash_table_.empty() ? hex_addr : HashFields(hex_addr);
+    return (field_addr >> ch_pos) & ch_mask;
+}
+
+std::vector<uint64_t> Config::BurstAddresses(uint64_t hex_addr,
+                                             uint32_t size) const {
+    uint64_t first = hex_addr >> shift_bits;
+    uint64_t last = (hex_addr + std::max(size, 1u) - 1) >> shift_bits;
+    std::vector<uint64_t> bursts;
+    for (uint64_t burst = first; burst <= last; burst++) {
+        bursts.push_back(burst << shift_bits);
+    }
+    return bursts;
+}
+
+uint64_t Config::HashFields(uint64_t addr) const {
+    uint64_t fields = 0;
+    for (size_t i = 0; addr != 0 && i < hash_table_.size(); i += 256) {
+        fields ^= hash_table_[i + (addr & 0xff)];
+        addr >>= 8;
+    }
+    return fields;
+}
+
 void Config::CalculateSize() {
     // calculate rank and re-calculate channel_size
     devices_per_rank = bus_width / device_width;
@@ -160,6 +242,8 @@ void Config::InitOtherParams() {
     // 1: default value, adds epoch CSV output on level 0
     // 2: adds histogram outputs in a different CSV format
     output_level = reader.GetInteger("other", "output_level", 1);
+    warmup_cycles = reader.GetInteger("other", "warmup_cycles", 0);
+    warmup_requests = reader.GetInteger("other", "warmup_requests", 0);
     // Other Parameters
     // give a prefix instead of specify the output name one by one...
     // this would allow outputing to a directory and you can always override
@@ -175,8 +259,42 @@ void Config::InitOtherParams() {
     output_prefix =
         output_dir + reader.Get("other", "output_prefix", "dramsim3");
     json_stats_name = output_prefix + ".json";
-    json_epoch_name = output_prefix + "epoch.json";
+    // epoch stats: json (array), ndjson (one object per line) or csv
+    epoch_format = reader.Get("other", "epoch_format", "json");
+    if (epoch_format == "json") {
+        epoch_stats_name = output_prefix + "epoch.json";
+    } else if (epoch_format == "ndjson") {
+        epoch_stats_name = output_prefix + "epoch.ndjson";
+    } else if (epoch_format == "csv") {
+        epoch_stats_name = output_prefix + "epoch.csv";
+    } else {
+        std::cerr << "Unknown epoch_format " << epoch_format << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    async_stats = reader.GetBoolean("other", "async_stats", false);
+    row_hotness = reader.GetBoolean("other", "row_hotness", false);
+    hot_rows_topk = GetInteger("other", "hot_rows_topk", 16);
+    cms_width = GetInteger("other", "cms_width", 4096);
+    cms_depth = GetInteger("other", "cms_depth", 4);
+    if (row_hotness && (hot_rows_topk <= 0 || cms_width <= 0 || cms_depth <= 0)) {
+        std::cerr << "hot_rows_topk, cms_width and cms_depth must be positive"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     txt_stats_name = output_prefix + ".txt";
+    addr_trace = reader.GetBoolean("other", "addr_trace", false);
+    addr_trace_name = output_prefix + "addr.bin";
+    live_stats = reader.GetBoolean("other", "live_stats", false);
+    live_stats_period = GetInteger("other", "live_stats_period", 100000);
+    live_stats_name = reader.Get("other", "live_stats_name",
+                                 "/dramsim3_" + std::to_string(getpid()));
+    if (live_stats && (live_stats_period <= 0 || live_stats_name.empty() ||
+                       live_stats_name[0] != '/')) {
+        std::cerr << "live_stats_period must be positive and live_stats_name "
+                     "must start with /"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     return;
 }
 
@@ -187,7 +305,7 @@ void Config::InitPowerParams() {
     double IDD0 = reader.GetReal("power", "IDD0", 48);
     double IDD2P = reader.GetReal("power", "IDD2P", 25);
     double IDD2N = reader.GetReal("power", "IDD2N", 34);
-    // double IDD3P = reader.GetReal("power", "IDD3P", 37);
+    double IDD3P = reader.GetReal("power", "IDD3P", 37);
     double IDD3N = reader.GetReal("power", "IDD3N", 43);
     double IDD4W = reader.GetReal("power", "IDD4W", 123);
     double IDD4R = reader.GetReal("power", "IDD4R", 135);
@@ -209,6 +327,7 @@ void Config::InitPowerParams() {
     // the following are added per cycle
     act_stb_energy_inc = VDD * IDD3N * devices;
     pre_stb_energy_inc = VDD * IDD2N * devices;
+    act_pd_energy_inc = VDD * IDD3P * devices;
     pre_pd_energy_inc = VDD * IDD2P * devices;
     sref_energy_inc = VDD * IDD6x * devices;
     return;
@@ -222,10 +341,53 @@ void Config::InitSystemParams() {
     address_mapping = reader.Get("system", "address_mapping", "chrobabgraco");
     queue_structure = reader.Get("system", "queue_structure", "PER_BANK");
     row_buf_policy = reader.Get("system", "row_buf_policy", "OPEN_PAGE");
+    if (row_buf_policy != "OPEN_PAGE" && row_buf_policy != "CLOSE_PAGE" &&
+        row_buf_policy != "ADAPTIVE" && row_buf_policy != "TIMEOUT") {
+        std::cerr << "Unsupported row buffer policy " << row_buf_policy
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    row_predictor_bits = GetInteger("system", "row_predictor_bits", 2);
+    row_timeout = GetInteger("system", "row_timeout", 100);
+    if (row_predictor_bits < 1 || row_predictor_bits > 8 || row_timeout < 1) {
+        std::cerr << "Invalid row buffer policy parameters" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    scheduler = reader.Get("system", "scheduler", "FRFCFS");
+    row_hit_cap = GetInteger("system", "row_hit_cap", 4);
+    num_sources = GetInteger("system", "num_sources", 1);
+    bliss_threshold = GetInteger("system", "bliss_threshold", 4);
+    bliss_clear_interval = GetInteger("system", "bliss_clear_interval", 10000);
+    parbs_batch_cap = GetInteger("system", "parbs_batch_cap", 5);
+    atlas_quantum = GetInteger("system", "atlas_quantum", 100000);
+    atlas_alpha = reader.GetReal("system", "atlas_alpha", 0.875);
+    atlas_starvation = GetInteger("system", "atlas_starvation", 100000);
+    if (num_sources <= 0 || bliss_threshold <= 0 ||
+        bliss_clear_interval <= 0 || parbs_batch_cap <= 0 ||
+        atlas_quantum <= 0 || atlas_starvation <= 0 || atlas_alpha < 0.0 ||
+        atlas_alpha >= 1.0) {
+        std::cerr << "Invalid scheduler parameters" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    bankgroup_interleave =
+        reader.GetBoolean("system", "bankgroup_interleave", false);
     cmd_queue_size = GetInteger("system", "cmd_queue_size", 16);
     trans_queue_size = GetInteger("system", "trans_queue_size", 32);
     unified_queue = reader.GetBoolean("system", "unified_queue", false);
-    write_buf_size = GetInteger("system", "write_buf_size", 16);
+    write_buf_size = GetInteger("system", "write_buf_size", trans_queue_size);
+    write_high_watermark =
+        GetInteger("system", "write_high_watermark", write_buf_size);
+    write_low_watermark = GetInteger("system", "write_low_watermark", 0);
+    write_min_drain = GetInteger("system", "write_min_drain", 8);
+    write_max_age = GetInteger("system", "write_max_age", 0);
+    write_coalescing = reader.GetBoolean("system", "write_coalescing", false);
+    if (write_buf_size <= 0 || write_high_watermark > write_buf_size ||
+        write_low_watermark < 0 ||
+        write_low_watermark >= write_high_watermark ||
+        write_min_drain <= 0 || write_max_age < 0) {
+        std::cerr << "Invalid write buffer watermarks" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     std::string ref_policy =
         reader.Get("system", "refresh_policy", "RANK_LEVEL_STAGGERED");
     if (ref_policy == "RANK_LEVEL_SIMULTANEOUS") {
@@ -237,10 +399,55 @@ void Config::InitSystemParams() {
     } else {
         AbruptExit(__FILE__, __LINE__);
     }
+    refresh_mode = GetInteger("system", "refresh_mode", 1);
+    refresh_postpone = GetInteger("system", "refresh_postpone", 0);
+    refresh_pullin = GetInteger("system", "refresh_pullin", 0);
+    if (refresh_mode != 1 && refresh_mode != 2 && refresh_mode != 4) {
+        std::cerr << "Unsupported refresh mode " << refresh_mode << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    // JEDEC allows at most 8 postponed or pulled in refreshes (in 1x mode)
+    int max_flexible = 8 * refresh_mode;
+    if (refresh_postpone < 0 || refresh_postpone > max_flexible ||
+        refresh_pullin < 0 || refresh_pullin > max_flexible) {
+        std::cerr << "refresh_postpone and refresh_pullin must be within 0 and "
+                  << max_flexible << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    if (refresh_policy == RefreshPolicy::BANK_LEVEL_STAGGERED &&
+        (refresh_postpone > 0 || refresh_pullin > 0)) {
+        std::cerr << "Refresh postponement needs a rank level refresh policy"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    retention_aware = reader.GetBoolean("system", "retention_aware", false);
+    retention_profile = reader.Get("system", "retention_profile", "");
+    // roughly the weak row counts reported for RAIDR
+    retention_rate_64ms = reader.GetReal("system", "retention_rate_64ms", 1e-5);
+    retention_rate_128ms =
+        reader.GetReal("system", "retention_rate_128ms", 3e-4);
+    retention_seed = GetInteger("system", "retention_seed", 1);
+    retention_bloom_bits_64ms =
+        GetInteger("system", "retention_bloom_bits_64ms", 2048);
+    retention_bloom_bits_128ms =
+        GetInteger("system", "retention_bloom_bits_128ms", 8192);
+    if (retention_aware &&
+        (refresh_policy == RefreshPolicy::BANK_LEVEL_STAGGERED ||
+         retention_rate_64ms < 0 || retention_rate_128ms < 0 ||
+         retention_bloom_bits_64ms <= 0 || retention_bloom_bits_128ms <= 0)) {
+        std::cerr << "Invalid retention aware refresh parameters" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
 
     enable_self_refresh =
         reader.GetBoolean("system", "enable_self_refresh", false);
     sref_threshold = GetInteger("system", "sref_threshold", 1000);
+    enable_power_down = reader.GetBoolean("system", "enable_power_down", false);
+    power_down_threshold = GetInteger("system", "power_down_threshold", 100);
+    if (enable_power_down && power_down_threshold <= 0) {
+        std::cerr << "power_down_threshold must be positive" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     aggressive_precharging_enabled =
         reader.GetBoolean("system", "aggressive_precharging_enabled", false);
 
@@ -322,6 +529,15 @@ void Config::InitTimingParams() {
     tRFCb = GetInteger("timing", "tRFCb", 20);
     tREFI = GetInteger("timing", "tREFI", 7800);
     tREFIb = GetInteger("timing", "tREFIb", 1950);
+    tRFC2 = GetInteger("timing", "tRFC2", tRFC);
+    tRFC4 = GetInteger("timing", "tRFC4", tRFC2);
+    // finer refreshes come more often and take less time each
+    if (refresh_mode == 2) {
+        tRFC = tRFC2;
+    } else if (refresh_mode == 4) {
+        tRFC = tRFC4;
+    }
+    tREFI /= refresh_mode;
     tFAW = GetInteger("timing", "tFAW", 50);
     tRPRE = GetInteger("timing", "tRPRE", 1);
     tWPRE = GetInteger("timing", "tWPRE", 1);
@@ -401,6 +617,81 @@ void Config::SetAddressMapping() {
     ba_mask = (1 << field_widths.at("ba")) - 1;
     ro_mask = (1 << field_widths.at("ro")) - 1;
     co_mask = (1 << field_widths.at("co")) - 1;
+
+    SetAddressHash(field_widths, field_pos, pos);
+}
+
+void Config::SetAddressHash(const std::map<std::string, int>& field_widths,
+                            const std::map<std::string, int>& field_pos,
+                            int addr_bits) {
+    // every bit of the shifted address feeds the same bit by default,
+    // ch_hash, ra_hash, bg_hash and ba_hash list the byte address bits XORed
+    // into each bit of their field, LSB first, e.g. ba_hash = 13^17, 14^18
+    std::vector<uint64_t> bit_masks;
+    for (int i = 0; i < addr_bits; i++) {
+        bit_masks.push_back(1ULL << i);
+    }
+    for (const std::string field : {"ch", "ra", "bg", "ba"}) {
+        std::string spec = reader_->Get("system", field + "_hash", "");
+        if (spec.empty()) {
+            continue;
+        }
+        address_hash += field + "_hash=" + spec + ";";
+        auto field_bits = StringSplit(spec, ',');
+        if (static_cast<int>(field_bits.size()) != field_widths.at(field)) {
+            std::cerr << field << "_hash needs " << field_widths.at(field)
+                      << " comma separated bits" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        for (size_t i = 0; i < field_bits.size(); i++) {
+            uint64_t mask = 0;
+            for (const auto& token : StringSplit(field_bits[i], '^')) {
+                char* end;
+                long bit = std::strtol(token.c_str(), &end, 10) - shift_bits;
+                while (*end == ' ') {
+                    end++;
+                }
+                if (end == token.c_str() || *end != '\0' || bit < 0 ||
+                    bit >= addr_bits) {
+                    std::cerr << "Invalid address bit " << token << " in "
+                              << field << "_hash" << std::endl;
+                    AbruptExit(__FILE__, __LINE__);
+                }
+                mask ^= 1ULL << bit;
+            }
+            bit_masks[field_pos.at(field) + i] = mask;
+        }
+    }
+    if (address_hash.empty()) {
+        return;
+    }
+    if (GF2Rank(bit_masks) != addr_bits) {
+        std::cerr << "Address hash maps different addresses to the same "
+                     "location"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    // what each byte of the shifted address flips in the hashed fields, so
+    // a mapping costs one lookup per byte
+    int num_bytes = (addr_bits + 7) / 8;
+    hash_table_.assign(num_bytes * 256, 0);
+    for (const std::string field : {"ch", "ra", "bg", "ba"}) {
+        for (int i = 0; i < field_widths.at(field); i++) {
+            int out_bit = field_pos.at(field) + i;
+            for (int in_bit = 0; in_bit < addr_bits; in_bit++) {
+                if (!((bit_masks[out_bit] >> in_bit) & 1)) {
+                    continue;
+                }
+                for (int val = 0; val < 256; val++) {
+                    if ((val >> (in_bit % 8)) & 1) {
+                        hash_table_[(in_bit / 8) * 256 + val] ^= 1ULL
+                                                                << out_bit;
+                    }
+                }
+            }
+        }
+    }
 }
 
 }  // namespace dramsim3
@@ -2,6 +2,7 @@
 #define __CONFIG_H
 
 #include <fstream>
+#include <map>
 #include <string>
 #include "common.h"
 
@@ -34,7 +35,15 @@ enum class RefreshPolicy {
 class Config {
    public:
     Config(std::string config_file, std::string out_dir);
+    // overrides are keyed by "section.key" and take precedence over the
+    // values in the config file, e.g. {"system.row_buf_policy", "CLOSE_PAGE"}
+    Config(std::string config_file, std::string out_dir,
+           const std::map<std::string, std::string>& overrides);
     Address AddressMapping(uint64_t hex_addr) const;
+    int Channel(uint64_t hex_addr) const;
+    // first address of each burst a request of size bytes touches
+    std::vector<uint64_t> BurstAddresses(uint64_t hex_addr,
+                                         uint32_t size) const;
     // DRAM physical structure
     DRAMProtocol protocol;
     int channel_size;
@@ -54,6 +63,9 @@ class Config {
     int shift_bits;
     int ch_pos, ra_pos, bg_pos, ba_pos, ro_pos, co_pos;
     uint64_t ch_mask, ra_mask, bg_mask, ba_mask, ro_mask, co_mask;
+    // the *_hash keys that turn channel/rank/bankgroup/bank into XORs of
+    // address bits, empty with the plain address_mapping layout
+    std::string address_hash;
 
     // Generic DRAM timing parameters
     double tCK;
@@ -75,7 +87,11 @@ class Config {
     int tRRD_S;
     int tRAS;
     int tRCD;
+    // tRFC and tREFI already account for the fine granularity refresh mode,
+    // tRFC2 and tRFC4 are the 2x and 4x mode values from the config
     int tRFC;
+    int tRFC2;
+    int tRFC4;
     int tRC;
     // tCKSRE and tCKSRX are only useful for changing clock freq after entering
     // SRE mode we are not doing that, so tCKESR is sufficient
@@ -108,6 +124,7 @@ class Config {
     double refb_energy_inc;
     double act_stb_energy_inc;
     double pre_stb_energy_inc;
+    double act_pd_energy_inc;
     double pre_pd_energy_inc;
     double sref_energy_inc;
 
@@ -123,25 +140,96 @@ class Config {
     // System
     std::string address_mapping;
     std::string queue_structure;
+    // OPEN_PAGE, CLOSE_PAGE, ADAPTIVE (per bank predictor of
+    // row_predictor_bits counters decides on auto-precharge) or TIMEOUT
+    // (open page, rows idle for row_timeout cycles are closed)
     std::string row_buf_policy;
+    int row_predictor_bits;
+    int row_timeout;
+    // command scheduler: FCFS, FRFCFS, BLISS, PARBS or ATLAS. Row hits may
+    // delay a precharge row_hit_cap times (<= 0 means no cap). Requests
+    // carry a source id (e.g. core), folded onto num_sources.
+    std::string scheduler;
+    int row_hit_cap;
+    int num_sources;
+    int bliss_threshold;
+    int bliss_clear_interval;
+    int parbs_batch_cap;
+    int atlas_quantum;
+    double atlas_alpha;
+    int atlas_starvation;
+    // prefer ready column commands to another bankgroup of the rank than
+    // the last column command, so they can go back to back at tCCD_S
+    bool bankgroup_interleave;
     RefreshPolicy refresh_policy;
+    // fine granularity refresh mode 1, 2 or 4. Rank level refreshes may be
+    // postponed by up to refresh_postpone while the rank has commands
+    // queued and pulled in by up to refresh_pullin while it is idle.
+    int refresh_mode;
+    int refresh_postpone;
+    int refresh_pullin;
+    // retention aware refresh skips rank refreshes whose rows are not due,
+    // rows are binned from retention_profile or synthetically with the
+    // given fractions of rows needing 64ms and 128ms refresh
+    bool retention_aware;
+    std::string retention_profile;
+    double retention_rate_64ms;
+    double retention_rate_128ms;
+    int retention_seed;
+    int retention_bloom_bits_64ms;
+    int retention_bloom_bits_128ms;
     int cmd_queue_size;
     bool unified_queue;
     int trans_queue_size;
+    // writes drain from the write buffer once write_high_watermark of them
+    // are buffered, or more than write_min_drain when the command queues are
+    // idle, or when the oldest is write_max_age cycles old (0 disables), down
+    // to write_low_watermark but at least write_min_drain writes per drain.
+    // write_coalescing merges writes to the same line and drains the open
+    // row of the last write first.
     int write_buf_size;
+    int write_high_watermark;
+    int write_low_watermark;
+    int write_min_drain;
+    int write_max_age;
+    bool write_coalescing;
     bool enable_self_refresh;
     int sref_threshold;
+    bool enable_power_down;
+    int power_down_threshold;
+    // close idle rows after row_timeout cycles with any row buffer policy
     bool aggressive_precharging_enabled;
     bool enable_hbm_dual_cmd;
 
 
     int epoch_period;
     int output_level;
+    // fast-forward (functional warm-up) until either marker is reached,
+    // 0 disables the marker
+    uint64_t warmup_cycles;
+    uint64_t warmup_requests;
     std::string output_dir;
     std::string output_prefix;
     std::string json_stats_name;
-    std::string json_epoch_name;
+    std::string epoch_format;
+    std::string epoch_stats_name;
+    // derive and write epoch stats on a background thread
+    bool async_stats;
+    // per row activation tracking with a count-min sketch of
+    // cms_width x cms_depth counters and the hot_rows_topk hottest rows
+    bool row_hotness;
+    int hot_rows_topk;
+    int cms_width;
+    int cms_depth;
     std::string txt_stats_name;
+    // record every accepted request into addr_trace_name for replay
+    bool addr_trace;
+    std::string addr_trace_name;
+    // publish headline stats every live_stats_period cycles into the
+    // POSIX shared memory segment live_stats_name
+    bool live_stats;
+    int live_stats_period;
+    std::string live_stats_name;
 
     // Computed parameters
     int request_size_bytes;
@@ -184,6 +272,10 @@ class Config {
 
    private:
     INIReader* reader_;
+    // indexed by byte of the shifted address and its value, the channel,
+    // rank, bankgroup and bank bits it sets, in address_mapping positions
+    std::vector<uint64_t> hash_table_;
+    uint64_t HashFields(uint64_t addr) const;
     void CalculateSize();
     DRAMProtocol GetDRAMProtocol(std::string protocol_str);
     int GetInteger(const std::string& sec, const std::string& opt,
@@ -197,6 +289,9 @@ class Config {
 #endif  // THERMAL
     void InitTimingParams();
     void SetAddressMapping();
+    void SetAddressHash(const std::map<std::string, int>& field_widths,
+                        const std::map<std::string, int>& field_pos,
+                        int addr_bits);
 };
 
 }  // namespace dramsim3
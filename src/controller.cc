@@ -1,11 +1,23 @@
 //this is controller.cc
 #include "controller.h"
+#include "checkpoint.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 
 namespace dramsim3 {
 
+namespace {
+// indexed by IdleCause
+const char *kIdleCauseStats[] = {
+    "idle_empty_cycles",      "idle_refresh_cycles",
+    "idle_row_cycles",        "idle_faw_cycles",
+    "idle_turnaround_cycles", "idle_rank_switch_cycles",
+    "idle_sref_cycles",       "idle_pd_cycles",
+    "idle_ccd_cycles",        "idle_other_cycles"};
+}  // namespace
+
 #ifdef THERMAL
 Controller::Controller(int channel, const Config &config, const Timing &timing,
                        ThermalCalculator &thermal_calc)
@@ -18,32 +30,55 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
       simple_stats_(config_, channel_id_),
       channel_state_(config, timing),
       cmd_queue_(channel_id_, config, channel_state_, simple_stats_),
-      refresh_(config, channel_state_),
+      refresh_(channel_id_, config, channel_state_, cmd_queue_, simple_stats_),
+      row_hotness_(config),
+      row_predictor_(config.ranks * config.banks, config.row_predictor_bits),
 #ifdef THERMAL
       thermal_calc_(thermal_calc),
 #endif  // THERMAL
       is_unified_queue_(config.unified_queue),
+      next_parent_id_(1),
       row_buf_policy_(config.row_buf_policy == "CLOSE_PAGE"
                           ? RowBufPolicy::CLOSE_PAGE
-                          : RowBufPolicy::OPEN_PAGE),
+                          : config.row_buf_policy == "ADAPTIVE"
+                                ? RowBufPolicy::ADAPTIVE
+                                : config.row_buf_policy == "TIMEOUT"
+                                      ? RowBufPolicy::TIMEOUT
+                                      : RowBufPolicy::OPEN_PAGE),
       last_trans_clk_(0),
+      bank_act_clk_(config.ranks * config.banks, 0),
+      bank_ref_end_clk_(config.ranks * config.banks, 0),
+      bank_access_clk_(config.ranks * config.banks, 0),
+      close_idle_rows_(config.row_buf_policy == "TIMEOUT" ||
+                       config.aggressive_precharging_enabled),
+      rank_cmd_clk_(config.ranks, 0),
+      data_bus_free_clk_(0),
+      last_col_rank_(-1),
+      last_col_is_write_(false),
       write_draining_(0) {
     if (is_unified_queue_) {
         unified_queue_.reserve(config_.trans_queue_size);
     } else {
         read_queue_.reserve(config_.trans_queue_size);
-        write_buffer_.reserve(config_.trans_queue_size);
+        write_buffer_.reserve(config_.write_buf_size);
     }
 
 #ifdef CMD_TRACE
     std::string trace_file_name = config_.output_prefix + "ch_" +
-                                  std::to_string(channel_id_) + "cmd.trace";
+                                  std::to_string(channel_id_) + "cmd.bin";
     std::cout << "Command Trace write to " << trace_file_name << std::endl;
-    cmd_trace_.open(trace_file_name, std::ofstream::out);
+    cmd_trace_.Open(trace_file_name);
 #endif  // CMD_TRACE
 }
 
 std::pair<uint64_t, int> Controller::ReturnDoneTrans(uint64_t clk) {
+    uint64_t request_id;
+    return ReturnDoneTrans(clk, request_id);
+}
+
+std::pair<uint64_t, int> Controller::ReturnDoneTrans(uint64_t clk,
+                                                     uint64_t &request_id) {
+    request_id = 0;
     auto it = return_queue_.begin();
 
 
@@ -61,20 +96,35 @@ std::pair<uint64_t, int> Controller::ReturnDoneTrans(uint64_t clk) {
     
     while (it != return_queue_.end()) {
         if (clk >= it->complete_cycle) {
+            // done counts are in bursts so that bandwidth adds up
+            uint64_t bursts =
+                it->size == 0 ? 1 : PartAddresses(it->addr, it->size).size();
             if (it->is_write) {
-                simple_stats_.Increment("num_writes_done");
+                simple_stats_.IncrementBy("num_writes_done", bursts);
             } else {
-                simple_stats_.Increment("num_reads_done");
+                simple_stats_.IncrementBy("num_reads_done", bursts);
                 simple_stats_.AddValue("read_latency", clk_ - it->added_cycle);
                 std::cout << "clk_: " << clk_ << std::endl;
                 std::cout << "it->added_cycle: " << it->added_cycle << std::endl; // The added_cycle starts from the moment transactions put into read_queue.
                 std::cout << "read_latency: " << clk_ - it->added_cycle << std::endl; 
             }
+            if (config_.num_sources > 1) {
+                if (it->is_write) {
+                    simple_stats_.IncrementVec("source_writes_done",
+                                               it->source);
+                } else {
+                    simple_stats_.IncrementVec("source_reads_done", it->source);
+                    simple_stats_.IncrementVecBy("source_read_cycles",
+                                                 it->source,
+                                                 clk_ - it->added_cycle);
+                }
+            }
             // add std::cout to print finished trans
             std::cout << "Completed Transaction: " << it->addr 
                       << ", Type: " << (it->is_write ? "WRITE" : "READ") << std::endl;
 
             auto pair = std::make_pair(it->addr, it->is_write);
+            request_id = it->request_id;
             it = return_queue_.erase(it);
             return pair;
         } else {
@@ -87,7 +137,10 @@ std::pair<uint64_t, int> Controller::ReturnDoneTrans(uint64_t clk) {
 
 void Controller::ClockTick() {
     // update refresh counter
-    refresh_.ClockTick();
+    {
+        PROFILE_SCOPE(profile_, ProfilePhase::REFRESH);
+        refresh_.ClockTick();
+    }
     /*
         // print unified_queue_
     if (is_unified_queue_) {
@@ -125,13 +178,16 @@ void Controller::ClockTick() {
 
     bool cmd_issued = false;
     Command cmd;
-    if (channel_state_.IsRefreshWaiting()) {
-        cmd = cmd_queue_.FinishRefresh();
-    }
+    {
+        PROFILE_SCOPE(profile_, ProfilePhase::GET_COMMAND);
+        if (channel_state_.IsRefreshWaiting()) {
+            cmd = cmd_queue_.FinishRefresh();
+        }
 
-    // cannot find a refresh related command or there's no refresh
-    if (!cmd.IsValid()) {
-        cmd = cmd_queue_.GetCommandToIssue();
+        // cannot find a refresh related command or there's no refresh
+        if (!cmd.IsValid()) {
+            cmd = cmd_queue_.GetCommandToIssue();
+        }
     }
 
     if (cmd.IsValid()) {
@@ -149,23 +205,42 @@ void Controller::ClockTick() {
         }
     }
 
+    if (clk_ >= data_bus_free_clk_) {
+        PROFILE_SCOPE(profile_, ProfilePhase::STATS);
+        simple_stats_.Increment(
+            kIdleCauseStats[static_cast<int>(ClassifyIdleCycle())]);
+    }
+
     // power updates pt 1
-    for (int i = 0; i < config_.ranks; i++) {
-        if (channel_state_.IsRankSelfRefreshing(i)) {
-            simple_stats_.IncrementVec("sref_cycles", i);
-        } else {
-            bool all_idle = channel_state_.IsAllBankIdleInRank(i);
-            if (all_idle) {
-                simple_stats_.IncrementVec("all_bank_idle_cycles", i);
+    {
+        PROFILE_SCOPE(profile_, ProfilePhase::STATS);
+        for (int i = 0; i < config_.ranks; i++) {
+            if (channel_state_.IsRankSelfRefreshing(i)) {
+                simple_stats_.IncrementVec("sref_cycles", i);
+            } else if (channel_state_.IsRankActivePowerDown(i)) {
+                simple_stats_.IncrementVec("act_pd_cycles", i);
+                channel_state_.rank_idle_cycles[i] = 0;
+            } else if (channel_state_.IsRankPoweredDown(i)) {
+                simple_stats_.IncrementVec("pre_pd_cycles", i);
                 channel_state_.rank_idle_cycles[i] += 1;
             } else {
-                simple_stats_.IncrementVec("rank_active_cycles", i);
-                // reset
-                channel_state_.rank_idle_cycles[i] = 0;
+                bool all_idle = channel_state_.IsAllBankIdleInRank(i);
+                if (all_idle) {
+                    simple_stats_.IncrementVec("all_bank_idle_cycles", i);
+                    channel_state_.rank_idle_cycles[i] += 1;
+                } else {
+                    simple_stats_.IncrementVec("rank_active_cycles", i);
+                    // reset
+                    channel_state_.rank_idle_cycles[i] = 0;
+                }
             }
         }
     }
 
+    if (close_idle_rows_ && !cmd_issued) {
+        cmd_issued = CloseIdleRow();
+    }
+
     // power updates pt 2: move idle ranks into self-refresh mode to save power
     if (config_.enable_self_refresh && !cmd_issued) {
         for (auto i = 0; i < config_.ranks; i++) {
@@ -178,6 +253,7 @@ void Controller::ClockTick() {
                     cmd = channel_state_.GetReadyCommand(cmd, clk_);
                     if (cmd.IsValid()) {
                         IssueCommand(cmd);
+                        cmd_issued = true;
                         break;
                     }
                 }
@@ -191,6 +267,7 @@ void Controller::ClockTick() {
                     cmd = channel_state_.GetReadyCommand(cmd, clk_);
                     if (cmd.IsValid()) {
                         IssueCommand(cmd);
+                        cmd_issued = true;
                         break;
                     }
                 }
@@ -198,20 +275,40 @@ void Controller::ClockTick() {
         }
     }
 
-    ScheduleTransaction();
+    // power updates pt 3: power down idle ranks, the commands that come in
+    // later wake them up on their own and pay tXP
+    if (config_.enable_power_down && !cmd_issued) {
+        cmd_issued = PowerDownIdleRank();
+    }
+
+    {
+        PROFILE_SCOPE(profile_, ProfilePhase::SCHEDULE_TRANS);
+        ScheduleTransaction();
+    }
     clk_++;
     cmd_queue_.ClockTick();
     simple_stats_.Increment("num_cycles");
     return;
 }
 
-bool Controller::WillAcceptTransaction(uint64_t hex_addr, bool is_write) const {
+bool Controller::WillAcceptTransaction(uint64_t hex_addr, bool is_write,
+                                       uint32_t size) const {
+    size_t parts = size == 0 ? 1 : PartAddresses(hex_addr, size).size();
+    size_t capacity = is_unified_queue_ ? unified_queue_.capacity()
+                      : is_write ? static_cast<size_t>(config_.write_buf_size)
+                                 : read_queue_.capacity();
+    if (parts > capacity) {
+        std::cerr << "A " << size << " byte request needs " << parts
+                  << " bursts, more than the transaction queue holds"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     if (is_unified_queue_) {
-        return unified_queue_.size() < unified_queue_.capacity();
+        return unified_queue_.size() + parts <= capacity;
     } else if (!is_write) {
-        return read_queue_.size() < read_queue_.capacity();
+        return read_queue_.size() + parts <= capacity;
     } else {
-        return write_buffer_.size() < write_buffer_.capacity();
+        return write_buffer_.size() + parts <= capacity;
     }
 }
 
@@ -221,64 +318,307 @@ bool Controller::AddTransaction(Transaction trans) {
     simple_stats_.AddValue("interarrival_latency", clk_ - last_trans_clk_);
     last_trans_clk_ = clk_;
 
-    if (trans.is_write) {
-        if (pending_wr_q_.count(trans.addr) == 0) {  // can not merge writes
-            pending_wr_q_.insert(std::make_pair(trans.addr, trans));
-            if (is_unified_queue_) {
-                unified_queue_.push_back(trans);
-            } else {
-                write_buffer_.push_back(trans);
+    // a DDR3/DDR4 request that fits half a burst can be burst chopped
+    // (BC4), it still occupies the bus for tCCD like a full burst
+    if (trans.size > 0 &&
+        trans.size * 2 <= static_cast<uint32_t>(config_.request_size_bytes) &&
+        config_.BL == 8 &&
+        (config_.protocol == DRAMProtocol::DDR3 || config_.IsDDR4())) {
+        simple_stats_.Increment("num_burst_chops");
+    }
+
+    if (config_.BurstAddresses(trans.addr, trans.size).size() > 1) {
+        // the parts of this channel are queued back to back, the request
+        // completes with its last part (writes once they are buffered)
+        simple_stats_.Increment("num_multi_burst_reqs");
+        auto parts = PartAddresses(trans.addr, trans.size);
+        uint64_t parent_id = next_parent_id_++;
+        if (!trans.is_write) {
+            parents_[parent_id] = trans;
+            parts_left_[parent_id] = parts.size();
+        }
+        for (auto addr : parts) {
+            Transaction part = trans;
+            part.addr = addr;
+            part.size = 0;
+            part.parent_id = parent_id;
+            if (trans.is_write) {
+                QueueWrite(part);
+            } else if (!QueueRead(part)) {
+                PartDone(parent_id);
             }
         }
+        if (trans.is_write) {
+            trans.complete_cycle = clk_ + 1;
+            return_queue_.push_back(trans);
+        }
+        return true;
+    }
+
+    if (trans.is_write) {
+        QueueWrite(trans);
         trans.complete_cycle = clk_ + 1;
         return_queue_.push_back(trans);
-        return true;
-    } else {  // read
-        // if in write buffer, use the write buffer value
+    } else if (!QueueRead(trans)) {
+        trans.complete_cycle = clk_ + 1;
+        return_queue_.push_back(trans);
+    }
+    return true;
+}
+
+void Controller::QueueWrite(const Transaction &trans) {
+    if (CoalesceWrite(trans)) {
+        simple_stats_.Increment("num_coalesced_writes");
+        return;
+    }
+    pending_wr_q_.insert(std::make_pair(trans.addr, trans));
+    if (is_unified_queue_) {
+        unified_queue_.push_back(trans);
+    } else {
+        write_buffer_.push_back(trans);
+    }
+}
+
+// returns false if the read is served by the write buffer right away
+bool Controller::QueueRead(const Transaction &trans) {
+    // if in write buffer, use the write buffer value
+    if (pending_wr_q_.count(trans.addr) > 0) {
+        simple_stats_.Increment("num_write_buf_hits");
+        return false;
+    }
+    pending_rd_q_.insert(std::make_pair(trans.addr, trans));
+    if (pending_rd_q_.count(trans.addr) == 1) {
+        if (is_unified_queue_) {
+            unified_queue_.push_back(trans);
+        } else {
+            read_queue_.push_back(trans);
+        }
+    }
+    return true;
+}
+
+void Controller::PartDone(uint64_t parent_id) {
+    if (--parts_left_[parent_id] > 0) {
+        return;
+    }
+    auto &parent = parents_[parent_id];
+    parent.complete_cycle = clk_ + 1;
+    return_queue_.push_back(parent);
+    parents_.erase(parent_id);
+    parts_left_.erase(parent_id);
+}
+
+std::vector<uint64_t> Controller::PartAddresses(uint64_t hex_addr,
+                                                uint32_t size) const {
+    std::vector<uint64_t> parts;
+    for (auto addr : config_.BurstAddresses(hex_addr, size)) {
+        if (config_.Channel(addr) == channel_id_) {
+            parts.push_back(addr);
+        }
+    }
+    return parts;
+}
+
+void Controller::WarmTransaction(const Transaction &trans) {
+    if (trans.is_write) {
+        if (is_unified_queue_) {
+            WarmRow(trans.addr);
+            return;
+        }
         if (pending_wr_q_.count(trans.addr) > 0) {
-            trans.complete_cycle = clk_ + 1;
-            return_queue_.push_back(trans);
-            return true;
+            return;
         }
-        pending_rd_q_.insert(std::make_pair(trans.addr, trans));
-        if (pending_rd_q_.count(trans.addr) == 1) {
-            if (is_unified_queue_) {
-                unified_queue_.push_back(trans);
-            } else {
-                read_queue_.push_back(trans);
+        // a full buffer retires its oldest write, which is when it
+        // touches the row buffer
+        if (write_buffer_.size() >=
+            static_cast<size_t>(config_.write_buf_size)) {
+            auto oldest = write_buffer_.begin();
+            pending_wr_q_.erase(pending_wr_q_.find(oldest->addr));
+            WarmRow(oldest->addr);
+            write_buffer_.erase(oldest);
+        }
+        Transaction buffered = trans;
+        buffered.added_cycle = clk_;
+        pending_wr_q_.insert(std::make_pair(buffered.addr, buffered));
+        write_buffer_.push_back(buffered);
+    } else if (pending_wr_q_.count(trans.addr) == 0) {
+        WarmRow(trans.addr);
+    }
+    return;
+}
+
+void Controller::WarmRow(uint64_t hex_addr) {
+    if (row_buf_policy_ != RowBufPolicy::CLOSE_PAGE) {
+        channel_state_.WarmRow(config_.AddressMapping(hex_addr));
+    }
+    return;
+}
+
+bool Controller::CloseIdleRow() {
+    for (int r = 0; r < config_.ranks; r++) {
+        for (int bg = 0; bg < config_.bankgroups; bg++) {
+            for (int b = 0; b < config_.banks_per_group; b++) {
+                if (!channel_state_.IsRowOpen(r, bg, b) ||
+                    clk_ - bank_access_clk_[BankIndex(r, bg, b)] <
+                        static_cast<uint64_t>(config_.row_timeout) ||
+                    !cmd_queue_.BankEmpty(r, bg, b)) {
+                    continue;
+                }
+                Command pre(CommandType::PRECHARGE,
+                            Address(channel_id_, r, bg, b, -1, -1), -1);
+                pre = channel_state_.GetReadyCommand(pre, clk_);
+                if (pre.IsValid()) {
+                    IssueCommand(pre);
+                    simple_stats_.Increment("num_timeout_pres");
+                    return true;
+                }
             }
         }
+    }
+    return false;
+}
+
+bool Controller::PowerDownIdleRank() {
+    for (int r = 0; r < config_.ranks; r++) {
+        if (channel_state_.IsRankSelfRefreshing(r) ||
+            channel_state_.IsRankPoweredDown(r) ||
+            channel_state_.IsRankRefreshWaiting(r) ||
+            !cmd_queue_.RankEmpty(r) ||
+            clk_ - rank_cmd_clk_[r] <
+                static_cast<uint64_t>(config_.power_down_threshold)) {
+            continue;
+        }
+        // leave it to the self-refresh policy once that is due
+        if (config_.enable_self_refresh &&
+            channel_state_.rank_idle_cycles[r] >= config_.sref_threshold) {
+            continue;
+        }
+        auto addr = Address();
+        addr.rank = r;
+        auto cmd = Command(CommandType::PD_ENTER, addr, -1);
+        cmd = channel_state_.GetReadyCommand(cmd, clk_);
+        if (cmd.cmd_type == CommandType::PD_ENTER) {
+            IssueCommand(cmd);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Controller::FastForward(uint64_t cycles) {
+    refresh_.FastForward(cycles);
+    cmd_queue_.FastForward(cycles);
+    clk_ += cycles;
+    // do not account the skipped cycles as one huge inter-arrival gap
+    last_trans_clk_ = clk_;
+    return;
+}
+
+bool Controller::CoalesceWrite(const Transaction &trans) {
+    if (pending_wr_q_.count(trans.addr) > 0) {
+        return true;
+    }
+    if (!config_.write_coalescing) {
+        return false;
+    }
+    // any buffered write to the same line takes the new data
+    uint64_t line = (trans.addr >> config_.shift_bits) << config_.shift_bits;
+    auto it = pending_wr_q_.lower_bound(line);
+    return it != pending_wr_q_.end() &&
+           it->first < line + (1ULL << config_.shift_bits);
+}
+
+bool Controller::ShouldDrainWrites() const {
+    int buffered = write_buffer_.size();
+    if (buffered == 0) {
+        return false;
+    }
+    if (buffered >= config_.write_high_watermark) {
+        return true;
+    }
+    if (buffered > config_.write_min_drain && cmd_queue_.QueueEmpty()) {
         return true;
     }
+    if (config_.write_max_age == 0) {
+        return false;
+    }
+    // coalescing moves row hits to the front, so the oldest can be anywhere
+    auto oldest = std::min_element(
+        write_buffer_.begin(), write_buffer_.end(),
+        [](const Transaction &a, const Transaction &b) {
+            return a.added_cycle < b.added_cycle;
+        });
+    return clk_ - oldest->added_cycle >=
+           static_cast<uint64_t>(config_.write_max_age);
 }
 
 void Controller::ScheduleTransaction() {
     // determine whether to schedule read or write
-    if (write_draining_ == 0 && !is_unified_queue_) {
-        // we basically have a upper and lower threshold for write buffer
-        if ((write_buffer_.size() >= write_buffer_.capacity()) ||
-            (write_buffer_.size() > 8 && cmd_queue_.QueueEmpty())) {
-            write_draining_ = write_buffer_.size();
-        }
+    if (write_draining_ == 0 && !is_unified_queue_ && ShouldDrainWrites()) {
+        int buffered = write_buffer_.size();
+        write_draining_ =
+            std::max(buffered - config_.write_low_watermark,
+                     std::min(buffered, config_.write_min_drain));
+        simple_stats_.Increment("num_write_drains");
     }
 
     std::vector<Transaction> &queue =
         is_unified_queue_ ? unified_queue_
                           : write_draining_ > 0 ? write_buffer_ : read_queue_;
-    for (auto it = queue.begin(); it != queue.end(); it++) {
+    if (write_draining_ > 0 && config_.write_coalescing) {
+        // keep draining into the row the last write went to
+        auto hit = std::find_if(
+            write_buffer_.begin(), write_buffer_.end(),
+            [this](const Transaction &trans) {
+                auto addr = config_.AddressMapping(trans.addr);
+                return addr.rank == last_write_addr_.rank &&
+                       addr.bankgroup == last_write_addr_.bankgroup &&
+                       addr.bank == last_write_addr_.bank &&
+                       addr.row == last_write_addr_.row;
+            });
+        if (hit != write_buffer_.end()) {
+            std::rotate(write_buffer_.begin(), hit, hit + 1);
+        }
+    }
+    // the following parts of a multi-burst request go along in the same
+    // cycle, so that their column commands queue up together as row hits
+    uint64_t following = 0;
+    for (auto it = queue.begin(); it != queue.end();) {
         auto cmd = TransToCommand(*it);
-        if (cmd_queue_.WillAcceptCommand(cmd.Rank(), cmd.Bankgroup(),
-                                         cmd.Bank())) {
-            if (!is_unified_queue_ && cmd.IsWrite()) {
-                // Enforce R->W dependency
-                if (pending_rd_q_.count(it->addr) > 0) {
-                    write_draining_ = 0;
-                    break;
-                }
-                write_draining_ -= 1;
+        if (!cmd_queue_.WillAcceptCommand(cmd.Rank(), cmd.Bankgroup(),
+                                          cmd.Bank())) {
+            if (following != 0) {
+                break;
+            }
+            it++;
+            continue;
+        }
+        if (!is_unified_queue_ && cmd.IsWrite()) {
+            // Enforce R->W dependency
+            if (pending_rd_q_.count(it->addr) > 0) {
+                write_draining_ = 0;
+                break;
             }
-            cmd_queue_.AddCommand(cmd);
-            queue.erase(it);
+            write_draining_ -= 1;
+            last_write_addr_ = cmd.addr;
+        }
+        if (row_buf_policy_ == RowBufPolicy::ADAPTIVE &&
+            !row_predictor_.Update(
+                BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()),
+                cmd.Row())) {
+            simple_stats_.Increment("num_row_mispredicts");
+        }
+        cmd_queue_.AddCommand(cmd);
+        auto pending = cmd.IsWrite() ? pending_wr_q_.equal_range(it->addr)
+                                     : pending_rd_q_.equal_range(it->addr);
+        for (auto p = pending.first; p != pending.second; p++) {
+            p->second.scheduled_cycle = clk_;
+        }
+        following = it->parent_id;
+        it = queue.erase(it);
+        if (following == 0 || it == queue.end() ||
+            it->parent_id != following ||
+            (!is_unified_queue_ && cmd.IsWrite() && write_draining_ == 0)) {
             break;
         }
     }
@@ -286,7 +626,7 @@ void Controller::ScheduleTransaction() {
 
 void Controller::IssueCommand(const Command &cmd) {
 #ifdef CMD_TRACE
-    cmd_trace_ << std::left << std::setw(18) << clk_ << " " << cmd << std::endl;
+    cmd_trace_.Write(clk_, cmd);
 #endif  // CMD_TRACE
 #ifdef THERMAL
     // add channel in, only needed by thermal module
@@ -305,9 +645,14 @@ void Controller::IssueCommand(const Command &cmd) {
             auto it = pending_rd_q_.find(cmd.hex_addr);
             it->second.complete_cycle = clk_ + 1;  // adjust read latency for NMP operation
             // it->second.complete_cycle = clk_ + config_.read_delay; 
+            UpdateStageStats(it->second, cmd);
             std::cout << "------------it->second.complete_cycle: " << it->second.complete_cycle << "------------" << std::endl;
             
-            return_queue_.push_back(it->second);
+            if (it->second.parent_id != 0) {
+                PartDone(it->second.parent_id);
+            } else {
+                return_queue_.push_back(it->second);
+            }
             pending_rd_q_.erase(it);
             num_reads -= 1;
         }
@@ -322,28 +667,50 @@ void Controller::IssueCommand(const Command &cmd) {
         simple_stats_.AddValue("write_latency", wr_lat);
         pending_wr_q_.erase(it);
     }
+    if (cmd.IsReadWrite()) {
+        data_bus_free_clk_ =
+            std::max(data_bus_free_clk_, clk_) + config_.burst_cycle;
+        last_col_rank_ = cmd.Rank();
+        last_col_is_write_ = cmd.IsWrite();
+    }
     // must update stats before states (for row hits)
-    UpdateCommandStats(cmd);
+    {
+        PROFILE_SCOPE(profile_, ProfilePhase::STATS);
+        UpdateCommandStats(cmd);
+        UpdateBankTimestamps(cmd);
+    }
+    PROFILE_SCOPE(profile_, ProfilePhase::UPDATE_STATES);
     channel_state_.UpdateTimingAndStates(cmd, clk_);
 }
 
 Command Controller::TransToCommand(const Transaction &trans) {
     auto addr = config_.AddressMapping(trans.addr);
     CommandType cmd_type;
-    if (row_buf_policy_ == RowBufPolicy::OPEN_PAGE) {
+    bool keep_open =
+        row_buf_policy_ == RowBufPolicy::ADAPTIVE
+            ? row_predictor_.KeepOpen(
+                  BankIndex(addr.rank, addr.bankgroup, addr.bank))
+            : row_buf_policy_ != RowBufPolicy::CLOSE_PAGE;
+    if (keep_open) {
         cmd_type = trans.is_write ? CommandType::WRITE : CommandType::READ;
     } else {
         cmd_type = trans.is_write ? CommandType::WRITE_PRECHARGE
                                   : CommandType::READ_PRECHARGE;
     }
-    return Command(cmd_type, addr, trans.addr);
+    Command cmd(cmd_type, addr, trans.addr);
+    cmd.source = trans.source;
+    return cmd;
 }
 
 int Controller::QueueUsage() const { return cmd_queue_.QueueUsage(); }
 
-void Controller::PrintEpochStats() {
+void Controller::PrintEpochStats(EpochWriter &epoch_writer) {
     simple_stats_.Increment("epoch_num");
-    simple_stats_.PrintEpochStats();
+    if (config_.row_hotness) {
+        simple_stats_.AttachData("hot_rows", row_hotness_.EpochHotRows());
+        row_hotness_.ClearEpoch();
+    }
+    simple_stats_.PrintEpochStats(epoch_writer);
 #ifdef THERMAL
     for (int r = 0; r < config_.ranks; r++) {
         double bg_energy = simple_stats_.RankBackgroundEnergy(r);
@@ -354,6 +721,9 @@ void Controller::PrintEpochStats() {
 }
 
 void Controller::PrintFinalStats() {
+    if (config_.row_hotness) {
+        simple_stats_.AttachData("hot_rows", row_hotness_.HotRows());
+    }
     simple_stats_.PrintFinalStats();
 
 #ifdef THERMAL
@@ -365,6 +735,191 @@ void Controller::PrintFinalStats() {
     return;
 }
 
+void Controller::SaveState(CheckpointWriter &out) const {
+    out.Write(clk_);
+    out.Write(unified_queue_);
+    out.Write(read_queue_);
+    out.Write(write_buffer_);
+    out.Write(pending_rd_q_);
+    out.Write(pending_wr_q_);
+    out.Write(return_queue_);
+    out.Write(parents_);
+    out.Write(parts_left_);
+    out.Write(next_parent_id_);
+    out.Write(last_trans_clk_);
+    out.Write(bank_act_clk_);
+    out.Write(bank_ref_end_clk_);
+    out.Write(bank_access_clk_);
+    out.Write(rank_cmd_clk_);
+    out.Write(data_bus_free_clk_);
+    out.Write(last_col_rank_);
+    out.Write(last_col_is_write_);
+    out.Write(write_draining_);
+    out.Write(last_write_addr_);
+    simple_stats_.SaveState(out);
+    channel_state_.SaveState(out);
+    cmd_queue_.SaveState(out);
+    refresh_.SaveState(out);
+    row_hotness_.SaveState(out);
+    row_predictor_.SaveState(out);
+}
+
+void Controller::LoadState(CheckpointReader &in) {
+    in.Read(clk_);
+    in.Read(unified_queue_);
+    in.Read(read_queue_);
+    in.Read(write_buffer_);
+    in.Read(pending_rd_q_);
+    in.Read(pending_wr_q_);
+    in.Read(return_queue_);
+    in.Read(parents_);
+    in.Read(parts_left_);
+    in.Read(next_parent_id_);
+    in.Read(last_trans_clk_);
+    in.Read(bank_act_clk_);
+    in.Read(bank_ref_end_clk_);
+    in.Read(bank_access_clk_);
+    in.Read(rank_cmd_clk_);
+    in.Read(data_bus_free_clk_);
+    in.Read(last_col_rank_);
+    in.Read(last_col_is_write_);
+    in.Read(write_draining_);
+    in.Read(last_write_addr_);
+    simple_stats_.LoadState(in);
+    channel_state_.LoadState(in);
+    cmd_queue_.LoadState(in);
+    refresh_.LoadState(in);
+    row_hotness_.LoadState(in);
+    row_predictor_.LoadState(in);
+}
+
+void Controller::UpdateStageStats(Transaction &trans, const Command &cmd) {
+    // reads merged into one already in the command queue skip the
+    // transaction queue
+    trans.scheduled_cycle = std::max(trans.scheduled_cycle, trans.added_cycle);
+    trans.column_cycle = clk_;
+    int bank = BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
+    // an ACT issued after the command was queued opened the row for it
+    uint64_t act_clk = bank_act_clk_[bank];
+    trans.act_cycle = act_clk > trans.scheduled_cycle ? act_clk : 0;
+
+    simple_stats_.AddValue("read_trans_queue_latency",
+                           trans.scheduled_cycle - trans.added_cycle);
+    if (trans.act_cycle > 0) {
+        simple_stats_.AddValue("read_cmd_queue_latency",
+                               trans.act_cycle - trans.scheduled_cycle);
+        simple_stats_.AddValue("read_row_latency",
+                               trans.column_cycle - trans.act_cycle);
+    } else {
+        simple_stats_.AddValue("read_cmd_queue_latency",
+                               trans.column_cycle - trans.scheduled_cycle);
+    }
+    simple_stats_.AddValue("read_data_latency",
+                           trans.complete_cycle - trans.column_cycle);
+    if (bank_ref_end_clk_[bank] > trans.scheduled_cycle) {
+        simple_stats_.Increment("num_reads_delayed_by_ref");
+    }
+}
+
+void Controller::UpdateBankTimestamps(const Command &cmd) {
+    rank_cmd_clk_[cmd.Rank()] = clk_;
+    if (cmd.IsReadWrite()) {
+        bank_access_clk_[BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank())] =
+            clk_;
+    }
+    switch (cmd.cmd_type) {
+        case CommandType::ACTIVATE:
+            bank_act_clk_[BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank())] =
+                clk_;
+            bank_access_clk_[BankIndex(cmd.Rank(), cmd.Bankgroup(),
+                                       cmd.Bank())] = clk_;
+            break;
+        case CommandType::REFRESH: {
+            int first = BankIndex(cmd.Rank(), 0, 0);
+            for (int i = first; i < first + config_.banks; i++) {
+                bank_ref_end_clk_[i] = clk_ + config_.tRFC;
+            }
+            break;
+        }
+        case CommandType::REFRESH_BANK:
+            bank_ref_end_clk_[BankIndex(cmd.Rank(), cmd.Bankgroup(),
+                                        cmd.Bank())] = clk_ + config_.tRFCb;
+            break;
+        default:
+            break;
+    }
+}
+
+IdleCause Controller::ClassifyIdleCycle() const {
+    if (channel_state_.IsRefreshWaiting()) {
+        return IdleCause::REFRESH;
+    }
+    if (cmd_queue_.QueueEmpty()) {
+        bool trans_empty = unified_queue_.empty() && read_queue_.empty() &&
+                           write_buffer_.empty();
+        return trans_empty ? IdleCause::EMPTY : IdleCause::OTHER;
+    }
+    // the command that can go first is the one holding the bus up
+    IdleCause cause = IdleCause::OTHER;
+    uint64_t earliest = std::numeric_limits<uint64_t>::max();
+    for (const auto &queue : cmd_queue_.GetQueues()) {
+        for (const auto &cmd : queue) {
+            uint64_t ready_clk;
+            IdleCause cmd_cause = ClassifyBlockedCommand(cmd, ready_clk);
+            if (ready_clk < earliest) {
+                earliest = ready_clk;
+                cause = cmd_cause;
+            }
+        }
+    }
+    return cause;
+}
+
+IdleCause Controller::ClassifyBlockedCommand(const Command &cmd,
+                                             uint64_t &ready_clk) const {
+    if (channel_state_.IsRankSelfRefreshing(cmd.Rank())) {
+        ready_clk = clk_;
+        return IdleCause::SREF;
+    } else if (channel_state_.IsRankPoweredDown(cmd.Rank())) {
+        ready_clk = clk_;
+        return IdleCause::POWER_DOWN;
+    }
+    int bank = BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
+    if (clk_ < bank_ref_end_clk_[bank]) {
+        ready_clk = bank_ref_end_clk_[bank];
+        return IdleCause::REFRESH;
+    }
+    auto required = channel_state_.GetRequiredCommand(cmd, ready_clk);
+    if (ready_clk <= clk_) {
+        ready_clk = clk_;
+        if (required.cmd_type == CommandType::ACTIVATE &&
+            !channel_state_.ActivationWindowOk(cmd.Rank(), clk_)) {
+            return IdleCause::FAW;
+        }
+        return IdleCause::OTHER;
+    }
+    if (required.IsReadWrite()) {
+        int trcd = config_.tRCD - config_.AL;
+        if (config_.IsGDDR() || config_.IsHBM()) {
+            trcd = required.IsWrite() ? config_.tRCDWR : config_.tRCDRD;
+        }
+        if (clk_ < bank_act_clk_[bank] + trcd) {
+            return IdleCause::ROW;
+        } else if (last_col_rank_ >= 0 && last_col_rank_ != cmd.Rank()) {
+            return IdleCause::RANK_SWITCH;
+        } else if (last_col_is_write_ != required.IsWrite()) {
+            return IdleCause::TURNAROUND;
+        } else if (last_col_rank_ == cmd.Rank()) {
+            return IdleCause::CCD;
+        }
+        return IdleCause::OTHER;
+    } else if (required.cmd_type == CommandType::SREF_EXIT) {
+        return IdleCause::SREF;
+    }
+    // ACT or PRE waiting on the bank
+    return IdleCause::ROW;
+}
+
 void Controller::UpdateCommandStats(const Command &cmd) {
     switch (cmd.cmd_type) {
         case CommandType::READ:
@@ -385,6 +940,12 @@ void Controller::UpdateCommandStats(const Command &cmd) {
             break;
         case CommandType::ACTIVATE:
             simple_stats_.Increment("num_act_cmds");
+            if (config_.row_hotness) {
+                row_hotness_.Activate(cmd.addr);
+                simple_stats_.IncrementVec(
+                    "bank_act_cmds",
+                    BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
+            }
             break;
         case CommandType::PRECHARGE:
             simple_stats_.Increment("num_pre_cmds");
@@ -401,6 +962,12 @@ void Controller::UpdateCommandStats(const Command &cmd) {
         case CommandType::SREF_EXIT:
             simple_stats_.Increment("num_srefx_cmds");
             break;
+        case CommandType::PD_ENTER:
+            simple_stats_.Increment("num_pde_cmds");
+            break;
+        case CommandType::PD_EXIT:
+            simple_stats_.Increment("num_pdx_cmds");
+            break;
         default:
             AbruptExit(__FILE__, __LINE__);
     }
@@ -4,12 +4,17 @@
 
 #include <fstream>
 #include <map>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "channel_state.h"
+#include "cmd_trace.h"
 #include "command_queue.h"
 #include "common.h"
+#include "profiler.h"
 #include "refresh.h"
+#include "row_hotness.h"
+#include "row_predictor.h"
 #include "simple_stats.h"
 
 #ifdef THERMAL
@@ -18,7 +23,22 @@
 
 namespace dramsim3 {
 
-enum class RowBufPolicy { OPEN_PAGE, CLOSE_PAGE, SIZE };
+enum class RowBufPolicy { OPEN_PAGE, CLOSE_PAGE, ADAPTIVE, TIMEOUT, SIZE };
+
+// Why the data bus had nothing to transfer in a cycle
+enum class IdleCause {
+    EMPTY,        // no requests queued
+    REFRESH,      // refresh pending or in progress
+    ROW,          // waiting on tRCD/tRP/tRAS and other bank timings
+    FAW,          // ACT held back by the tFAW/t32AW window
+    TURNAROUND,   // read/write turnaround
+    RANK_SWITCH,  // tRTRS
+    SREF,         // rank in or exiting self-refresh
+    POWER_DOWN,   // rank waiting to exit power-down
+    CCD,          // column command waiting on tCCD_L/tCCD_S
+    OTHER,        // ready but not picked, scheduling delay
+    SIZE
+};
 
 class Controller {
    public:
@@ -29,17 +49,39 @@ class Controller {
     Controller(int channel, const Config &config, const Timing &timing);
 #endif  // THERMAL
     void ClockTick();
-    bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const;
+    // size in bytes, 0 is one burst
+    bool WillAcceptTransaction(uint64_t hex_addr, bool is_write,
+                               uint32_t size = 0) const;
     bool AddTransaction(Transaction trans);
+    // fast-forward mode: update row buffer and write buffer state without
+    // timing, and skip cycles without ticking
+    void WarmTransaction(const Transaction &trans);
+    void FastForward(uint64_t cycles);
     int QueueUsage() const;
     // Stats output
-    void PrintEpochStats();
+    void PrintEpochStats(EpochWriter &epoch_writer);
     void PrintFinalStats();
     void ResetStats() { simple_stats_.Reset(); }
+    void BeginPhase(const std::string &name) { simple_stats_.BeginPhase(name); }
+    void EndPhase() { simple_stats_.EndPhase(); }
+    StatsSnapshot GetStatsSnapshot() const {
+        return simple_stats_.GetSnapshot();
+    }
+    uint64_t GetCounter(const std::string &name) const {
+        return simple_stats_.GetCounter(name);
+    }
+    void SaveState(CheckpointWriter &out) const;
+    void LoadState(CheckpointReader &in);
     std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clock);
+    // same, also returns the request_id of the transaction
+    std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clock,
+                                             uint64_t &request_id);
 
     int channel_id_;
     int GetPendingReadQueueSize() const;
+#ifdef PROFILE
+    const PhaseProfile &GetProfile() const { return profile_; }
+#endif  // PROFILE
 
    private:
     uint64_t clk_;
@@ -48,6 +90,8 @@ class Controller {
     ChannelState channel_state_;
     CommandQueue cmd_queue_;
     Refresh refresh_;
+    RowHotness row_hotness_;
+    RowPredictor row_predictor_;
 
 #ifdef THERMAL
     ThermalCalculator &thermal_calc_;
@@ -66,22 +110,69 @@ class Controller {
     // completed transactions
     std::vector<Transaction> return_queue_;
 
+    // multi-burst reads by id, each completes when its last part does
+    std::unordered_map<uint64_t, Transaction> parents_;
+    std::unordered_map<uint64_t, int> parts_left_;
+    uint64_t next_parent_id_;
+
     // row buffer policy
     RowBufPolicy row_buf_policy_;
 
 #ifdef CMD_TRACE
-    std::ofstream cmd_trace_;
+    CmdTraceWriter cmd_trace_;
 #endif  // CMD_TRACE
 
+#ifdef PROFILE
+    PhaseProfile profile_;
+#endif  // PROFILE
+
     // used to calculate inter-arrival latency
     uint64_t last_trans_clk_;
 
-    // transaction queueing
+    // per bank cycle of the last ACT and end of the last refresh, used to
+    // break read latency down by stage
+    std::vector<uint64_t> bank_act_clk_;
+    std::vector<uint64_t> bank_ref_end_clk_;
+    // per bank cycle of the last ACT or column command, to close idle rows
+    std::vector<uint64_t> bank_access_clk_;
+    bool close_idle_rows_;
+    // per rank cycle of the last command, to power down idle ranks
+    std::vector<uint64_t> rank_cmd_clk_;
+
+    // data bus occupancy and the last column command, used to tell why the
+    // bus idles
+    uint64_t data_bus_free_clk_;
+    int last_col_rank_;
+    bool last_col_is_write_;
+
+    // transaction queueing, write_draining_ counts the writes left in the
+    // current drain and last_write_addr_ is where the last one went
     int write_draining_;
+    Address last_write_addr_;
     void ScheduleTransaction();
+    bool ShouldDrainWrites() const;
+    bool CoalesceWrite(const Transaction &trans);
+    void QueueWrite(const Transaction &trans);
+    bool QueueRead(const Transaction &trans);
+    void PartDone(uint64_t parent_id);
+    std::vector<uint64_t> PartAddresses(uint64_t hex_addr,
+                                        uint32_t size) const;
+    void WarmRow(uint64_t hex_addr);
+    bool CloseIdleRow();
+    bool PowerDownIdleRank();
     void IssueCommand(const Command &tmp_cmd);
     Command TransToCommand(const Transaction &trans);
     void UpdateCommandStats(const Command &cmd);
+    int BankIndex(int rank, int bankgroup, int bank) const {
+        return (rank * config_.bankgroups + bankgroup) *
+                   config_.banks_per_group +
+               bank;
+    }
+    void UpdateStageStats(Transaction &trans, const Command &cmd);
+    void UpdateBankTimestamps(const Command &cmd);
+    IdleCause ClassifyIdleCycle() const;
+    IdleCause ClassifyBlockedCommand(const Command &cmd,
+                                     uint64_t &ready_clk) const;
 };
 }  // namespace dramsim3
 #endif
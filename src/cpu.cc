@@ -52,8 +52,7 @@ void StreamCPU::ClockTick() {
 
 TraceBasedCPU::TraceBasedCPU(const std::string& config_file, const std::string& output_dir, const std::string& trace_file)
     : CPU(config_file, output_dir), trace_file_(trace_file) {
-    trace_file_.open(trace_file);
-    if (trace_file_.fail()) {
+    if (!trace_file_.IsOpen()) {
         std::cerr << "Trace file does not exist" << std::endl;
         AbruptExit(__FILE__, __LINE__);
     }
@@ -61,16 +60,28 @@ TraceBasedCPU::TraceBasedCPU(const std::string& config_file, const std::string&
 
 void TraceBasedCPU::ClockTick() {
     memory_system_.ClockTick();
-    if (!trace_file_.eof()) {
+    while (true) {
         if (get_next_) {
             get_next_ = false;
-            trace_file_ >> trans_;
+            has_trans_ = trace_file_.Next(record_);
         }
-        if (trans_.added_cycle <= clk_) {
-            get_next_ = memory_system_.WillAcceptTransaction(trans_.addr, trans_.is_write);
+        if (!has_trans_ || record_.trans.added_cycle > clk_) {
+            break;
+        }
+        // markers take effect right away, requests may have to wait
+        if (record_.type == TraceRecordType::ROI_BEGIN) {
+            memory_system_.BeginROI(record_.roi_name);
+            get_next_ = true;
+        } else if (record_.type == TraceRecordType::ROI_END) {
+            memory_system_.EndROI();
+            get_next_ = true;
+        } else {
+            const auto& trans = record_.trans;
+            get_next_ = memory_system_.WillAcceptTransaction(trans.addr, trans.is_write);
             if (get_next_) {
-                memory_system_.AddTransaction(trans_.addr, trans_.is_write);
+                memory_system_.AddTransaction(trans.addr, trans.is_write, record_.tag);
             }
+            break;
         }
     }
     clk_++;
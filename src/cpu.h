@@ -7,6 +7,7 @@
 #include <random>
 #include <string>
 #include <queue>
+#include "addr_trace.h"
 #include "memory_system.h"
 
 namespace dramsim3 {
@@ -24,8 +25,8 @@ class CPU {
    protected:
     MemorySystem memory_system_;
     uint64_t clk_;
-    void ReadCallBack(uint64_t addr) {}
-    void WriteCallBack(uint64_t addr) {}
+    virtual void ReadCallBack(uint64_t addr) {}
+    virtual void WriteCallBack(uint64_t addr) {}
 };
 
 class RandomCPU : public CPU {
@@ -59,12 +60,12 @@ class TraceBasedCPU : public CPU {
    public:
     TraceBasedCPU(const std::string& config_file, const std::string& output_dir,
                   const std::string& trace_file);
-    ~TraceBasedCPU() { trace_file_.close(); }
     void ClockTick() override;
 
    private:
-    std::ifstream trace_file_;
-    Transaction trans_;
+    AddrTraceReader trace_file_;
+    TraceRecord record_;
+    bool has_trans_ = false;
     bool get_next_ = true;
 };
 
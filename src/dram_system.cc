@@ -1,13 +1,17 @@
 //this is dram system.cc
 #include "dram_system.h"
+#include "checkpoint.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 namespace dramsim3 {
 
 // alternative way is to assign the id in constructor but this is less
 // destructive
-int BaseDRAMSystem::total_channels_ = 0;
+std::atomic<int> BaseDRAMSystem::total_channels_(0);
 
 BaseDRAMSystem::BaseDRAMSystem(Config &config, const std::string &output_dir,
                                std::function<void(uint64_t)> read_callback,
@@ -20,30 +24,28 @@ BaseDRAMSystem::BaseDRAMSystem(Config &config, const std::string &output_dir,
 #ifdef THERMAL
       thermal_calc_(config_),
 #endif  // THERMAL
-      clk_(0) {
+      clk_(0),
+      epoch_writer_(config_) {
     total_channels_ += config_.channels;
-
-#ifdef ADDR_TRACE
-    std::string addr_trace_name = config_.output_prefix + "addr.trace";
-    address_trace_.open(addr_trace_name);
-#endif
+    if (config_.live_stats) {
+        if (config_.channels > kLiveStatsMaxChannels) {
+            std::cerr << "Live stats support up to " << kLiveStatsMaxChannels
+                      << " channels" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        live_stats_.Open(config_.live_stats_name);
+        std::cout << "Live stats published to " << config_.live_stats_name
+                  << std::endl;
+    }
 }
 
 int BaseDRAMSystem::GetChannel(uint64_t hex_addr) const {
-    hex_addr >>= config_.shift_bits;
-    return (hex_addr >> config_.ch_pos) & config_.ch_mask;
+    return config_.Channel(hex_addr);
 }
 
 void BaseDRAMSystem::PrintEpochStats() {
-    // first epoch, print bracket
-    if (clk_ - config_.epoch_period == 0) {
-        std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::out);
-        epoch_out << "[";
-    }
     for (size_t i = 0; i < ctrls_.size(); i++) {
-        ctrls_[i]->PrintEpochStats();
-        std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::app);
-        epoch_out << "," << std::endl;
+        ctrls_[i]->PrintEpochStats(epoch_writer_);
     }
 #ifdef THERMAL
     thermal_calc_.PrintTransPT(clk_);
@@ -52,13 +54,8 @@ void BaseDRAMSystem::PrintEpochStats() {
 }
 
 void BaseDRAMSystem::PrintStats() {
-    // Finish epoch output, remove last comma and append ]
-    std::ofstream epoch_out(config_.json_epoch_name, std::ios_base::in |
-                                                         std::ios_base::out |
-                                                         std::ios_base::ate);
-    epoch_out.seekp(-2, std::ios_base::cur);
-    epoch_out.write("]", 1);
-    epoch_out.close();
+    // complete the epoch output so far, the file stays open for more epochs
+    epoch_writer_.Flush();
 
     std::ofstream json_out(config_.json_stats_name, std::ofstream::out);
     json_out << "{";
@@ -75,9 +72,53 @@ void BaseDRAMSystem::PrintStats() {
     json_out.open(config_.json_stats_name, std::ofstream::app);
     json_out << "}";
 
+    if (live_stats_.IsOpen()) {
+        PublishLiveStats();
+        live_stats_.Close();
+    }
+
 #ifdef THERMAL
     thermal_calc_.PrintFinalPT(clk_);
 #endif  // THERMAL
+
+#ifdef PROFILE
+    std::vector<const PhaseProfile *> profiles;
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        profiles.push_back(&ctrls_[i]->GetProfile());
+    }
+    auto stats = GetStatsSnapshot();
+    profile_clock_.Report(std::cout, profiles, clk_,
+                          stats.num_reads_done + stats.num_writes_done);
+#endif  // PROFILE
+}
+
+void BaseDRAMSystem::PublishLiveStats() {
+    LiveStatsData data;
+    std::memset(&data, 0, sizeof(data));
+    data.clk = clk_;
+    data.wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    data.num_channels = ctrls_.size();
+    StatsSnapshot stats;
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        auto channel_stats = ctrls_[i]->GetStatsSnapshot();
+        auto &channel = data.channels[i];
+        channel.num_reads_done = channel_stats.num_reads_done;
+        channel.num_writes_done = channel_stats.num_writes_done;
+        channel.queue_usage = ctrls_[i]->QueueUsage();
+        channel.pending_reads = ctrls_[i]->GetPendingReadQueueSize();
+        stats.Merge(channel_stats);
+    }
+    data.tCK = config_.tCK;
+    data.bandwidth = stats.Bandwidth();
+    data.row_hit_rate = stats.RowHitRate();
+    data.average_read_latency = stats.AverageReadLatency();
+    data.p50_read_latency = stats.ReadLatencyPercentile(50);
+    data.p99_read_latency = stats.ReadLatencyPercentile(99);
+    data.num_reads_done = stats.num_reads_done;
+    data.num_writes_done = stats.num_writes_done;
+    live_stats_.Publish(data);
 }
 
 void BaseDRAMSystem::ResetStats() {
@@ -86,6 +127,79 @@ void BaseDRAMSystem::ResetStats() {
     }
 }
 
+void BaseDRAMSystem::BeginROI(const std::string &name) {
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->BeginPhase(name);
+    }
+}
+
+void BaseDRAMSystem::EndROI() {
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->EndPhase();
+    }
+}
+
+StatsSnapshot BaseDRAMSystem::GetStatsSnapshot() const {
+    StatsSnapshot snapshot;
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        snapshot.Merge(ctrls_[i]->GetStatsSnapshot());
+    }
+    return snapshot;
+}
+
+void BaseDRAMSystem::WarmTransaction(uint64_t hex_addr, bool is_write) {
+    std::cerr << "Fast-forward is not supported by this memory system!"
+              << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
+void BaseDRAMSystem::FastForward(uint64_t cycles) {
+    std::cerr << "Fast-forward is not supported by this memory system!"
+              << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
+bool BaseDRAMSystem::WillAcceptSizedTransaction(uint64_t hex_addr,
+                                                bool is_write,
+                                                uint32_t size) const {
+    if (config_.BurstAddresses(hex_addr, size).size() > 1) {
+        std::cerr << "Multi-burst requests are not supported by this memory "
+                     "system!"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return WillAcceptTransaction(hex_addr, is_write);
+}
+
+bool BaseDRAMSystem::AddSizedTransaction(uint64_t hex_addr, bool is_write,
+                                         uint32_t size, uint32_t source) {
+    if (config_.BurstAddresses(hex_addr, size).size() > 1) {
+        std::cerr << "Multi-burst requests are not supported by this memory "
+                     "system!"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return AddTransaction(hex_addr, is_write, source);
+}
+
+bool BaseDRAMSystem::SaveState(CheckpointWriter &out) const {
+    out.Write(clk_);
+    out.Write(last_req_clk_);
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->SaveState(out);
+    }
+    return true;
+}
+
+bool BaseDRAMSystem::LoadState(CheckpointReader &in) {
+    in.Read(clk_);
+    in.Read(last_req_clk_);
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->LoadState(in);
+    }
+    return true;
+}
+
 void BaseDRAMSystem::RegisterCallbacks(
     std::function<void(uint64_t)> read_callback,
     std::function<void(uint64_t)> write_callback) {
@@ -97,7 +211,8 @@ void BaseDRAMSystem::RegisterCallbacks(
 JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
                                  std::function<void(uint64_t)> read_callback,
                                  std::function<void(uint64_t)> write_callback)
-    : BaseDRAMSystem(config, output_dir, read_callback, write_callback) {
+    : BaseDRAMSystem(config, output_dir, read_callback, write_callback),
+      next_request_id_(1) {
     if (config_.IsHMC()) {
         std::cerr << "Initialized a memory system with an HMC config file!"
                   << std::endl;
@@ -115,6 +230,8 @@ JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
 }
 
 JedecDRAMSystem::~JedecDRAMSystem() {
+    // pending epoch stats still refer to the controllers
+    epoch_writer_.Close();
     for (auto it = ctrls_.begin(); it != ctrls_.end(); it++) {
         delete (*it);
     }
@@ -126,34 +243,90 @@ bool JedecDRAMSystem::WillAcceptTransaction(uint64_t hex_addr,
     return ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write);
 }
 
+bool JedecDRAMSystem::WillAcceptSizedTransaction(uint64_t hex_addr,
+                                                 bool is_write,
+                                                 uint32_t size) const {
+    for (int channel : RequestChannels(hex_addr, size)) {
+        if (!ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write,
+                                                    size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool JedecDRAMSystem::AddTransaction(uint64_t hex_addr, bool is_write) {
-// Record trace - Record address trace for debugging or other purposes
-#ifdef ADDR_TRACE
-    address_trace_ << std::hex << hex_addr << std::dec << " "
-                   << (is_write ? "WRITE " : "READ ") << clk_ << std::endl;
-#endif
+    return AddTransaction(hex_addr, is_write, 0);
+}
 
-    int channel = GetChannel(hex_addr);
-    bool ok = ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write);
+bool JedecDRAMSystem::AddTransaction(uint64_t hex_addr, bool is_write,
+                                     uint32_t source) {
+    return AddSizedTransaction(hex_addr, is_write, 0, source);
+}
+
+bool JedecDRAMSystem::AddSizedTransaction(uint64_t hex_addr, bool is_write,
+                                          uint32_t size, uint32_t source) {
+    bool ok = WillAcceptSizedTransaction(hex_addr, is_write, size);
 
     assert(ok);
     if (ok) {
         Transaction trans = Transaction(hex_addr, is_write);
-        ctrls_[channel]->AddTransaction(trans);
+        trans.source = source % config_.num_sources;
+        trans.size = size;
+        // each channel takes the bursts that map to it
+        auto channels = RequestChannels(hex_addr, size);
+        if (channels.size() > 1) {
+            trans.request_id = next_request_id_++;
+            split_requests_[trans.request_id] = channels.size();
+        }
+        for (int channel : channels) {
+            ctrls_[channel]->AddTransaction(trans);
+        }
     }
     last_req_clk_ = clk_;
     return ok;
 }
 
+std::vector<int> JedecDRAMSystem::RequestChannels(uint64_t hex_addr,
+                                                  uint32_t size) const {
+    std::vector<int> channels;
+    for (auto addr : config_.BurstAddresses(hex_addr, size)) {
+        int channel = GetChannel(addr);
+        if (std::find(channels.begin(), channels.end(), channel) ==
+            channels.end()) {
+            channels.push_back(channel);
+        }
+    }
+    return channels;
+}
+
+// a request split over channels is done when the last channel returns it
+bool JedecDRAMSystem::RequestDone(uint64_t request_id) {
+    if (request_id == 0) {
+        return true;
+    }
+    auto it = split_requests_.find(request_id);
+    if (--it->second > 0) {
+        return false;
+    }
+    split_requests_.erase(it);
+    return true;
+}
+
 void JedecDRAMSystem::ClockTick() {
     for (size_t i = 0; i < ctrls_.size(); i++) {
         // look ahead and return earlier
         while (true) {
-            auto pair = ctrls_[i]->ReturnDoneTrans(clk_);
+            uint64_t request_id;
+            auto pair = ctrls_[i]->ReturnDoneTrans(clk_, request_id);
             if (pair.second == 1) {
-                write_callback_(pair.first);
+                if (RequestDone(request_id)) {
+                    write_callback_(pair.first);
+                }
             } else if (pair.second == 0) {
-                read_callback_(pair.first);
+                if (RequestDone(request_id)) {
+                    read_callback_(pair.first);
+                }
             } else {
                 break;
             }
@@ -167,15 +340,53 @@ void JedecDRAMSystem::ClockTick() {
     if (clk_ % config_.epoch_period == 0) {
         PrintEpochStats();
     }
+    if (config_.live_stats && clk_ % config_.live_stats_period == 0) {
+        PublishLiveStats();
+    }
+    return;
+}
+
+bool JedecDRAMSystem::SaveState(CheckpointWriter &out) const {
+    BaseDRAMSystem::SaveState(out);
+    out.Write(split_requests_);
+    out.Write(next_request_id_);
+    return true;
+}
+
+bool JedecDRAMSystem::LoadState(CheckpointReader &in) {
+    BaseDRAMSystem::LoadState(in);
+    in.Read(split_requests_);
+    in.Read(next_request_id_);
+    return true;
+}
+
+void JedecDRAMSystem::WarmTransaction(uint64_t hex_addr, bool is_write) {
+    int channel = GetChannel(hex_addr);
+    ctrls_[channel]->WarmTransaction(Transaction(hex_addr, is_write));
+    return;
+}
+
+void JedecDRAMSystem::FastForward(uint64_t cycles) {
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->FastForward(cycles);
+    }
+    clk_ += cycles;
+    last_req_clk_ = clk_;
     return;
 }
 
 /////////////////////////// add for NMP core
 std::pair<uint64_t, int> JedecDRAMSystem::ReturnDoneTrans(uint64_t clk) {
     for (size_t i = 0; i < ctrls_.size(); ++i) {
-        auto pair = ctrls_[i]->ReturnDoneTrans(clk);
-        if (pair.first != static_cast<uint64_t>(-1)) {
-            return pair;
+        while (true) {
+            uint64_t request_id;
+            auto pair = ctrls_[i]->ReturnDoneTrans(clk, request_id);
+            if (pair.first == static_cast<uint64_t>(-1)) {
+                break;
+            }
+            if (RequestDone(request_id)) {
+                return pair;
+            }
         }
     }
     return std::make_pair(static_cast<uint64_t>(-1), -1);
@@ -217,4 +428,18 @@ void IdealDRAMSystem::ClockTick() {
     return;
 }
 
+bool IdealDRAMSystem::SaveState(CheckpointWriter &out) const {
+    out.Write(clk_);
+    out.Write(last_req_clk_);
+    out.Write(infinite_buffer_q_);
+    return true;
+}
+
+bool IdealDRAMSystem::LoadState(CheckpointReader &in) {
+    in.Read(clk_);
+    in.Read(last_req_clk_);
+    in.Read(infinite_buffer_q_);
+    return true;
+}
+
 }  // namespace dramsim3
@@ -2,13 +2,18 @@
 #ifndef __DRAM_SYSTEM_H
 #define __DRAM_SYSTEM_H
 
+#include <atomic>
 #include <fstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common.h"
 #include "configuration.h"
 #include "controller.h"
+#include "epoch_writer.h"
+#include "live_stats.h"
+#include "profiler.h"
 #include "timing.h"
 
 #ifdef THERMAL
@@ -17,6 +22,9 @@
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class BaseDRAMSystem {
    public:
     BaseDRAMSystem(Config &config, const std::string &output_dir,
@@ -27,16 +35,40 @@ class BaseDRAMSystem {
                            std::function<void(uint64_t)> write_callback);
     void PrintEpochStats();
     void PrintStats();
+    void PublishLiveStats();
     void ResetStats();
+    void BeginROI(const std::string &name);
+    void EndROI();
+    StatsSnapshot GetStatsSnapshot() const;
+
+    // checkpointing, returns false if the system cannot be checkpointed
+    virtual bool SaveState(CheckpointWriter &out) const;
+    virtual bool LoadState(CheckpointReader &in);
 
     virtual bool WillAcceptTransaction(uint64_t hex_addr,
                                        bool is_write) const = 0;
     virtual bool AddTransaction(uint64_t hex_addr, bool is_write) = 0;
+    // source identifies the requester for the command schedulers
+    virtual bool AddTransaction(uint64_t hex_addr, bool is_write,
+                                uint32_t source) {
+        return AddTransaction(hex_addr, is_write);
+    }
+    // requests of size bytes, split into one part per burst they touch,
+    // not every system supports more than one burst
+    virtual bool WillAcceptSizedTransaction(uint64_t hex_addr, bool is_write,
+                                            uint32_t size) const;
+    virtual bool AddSizedTransaction(uint64_t hex_addr, bool is_write,
+                                     uint32_t size, uint32_t source);
     virtual void ClockTick() = 0;
+    // fast-forward (functional warm-up) support, not every system has it
+    virtual void WarmTransaction(uint64_t hex_addr, bool is_write);
+    virtual void FastForward(uint64_t cycles);
     int GetChannel(uint64_t hex_addr) const;
+    uint64_t GetClk() const { return clk_; }
 
     std::function<void(uint64_t req_id)> read_callback_, write_callback_;
-    static int total_channels_;
+    // shared by all instances, which may live on different threads
+    static std::atomic<int> total_channels_;
 
     virtual std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clk) = 0; //////////// add for NMP core
     int GetPendingReadQueueCount() const; //////////// add for NMP core
@@ -58,9 +90,12 @@ class BaseDRAMSystem {
     uint64_t clk_;
     std::vector<Controller*> ctrls_;
 
-#ifdef ADDR_TRACE
-    std::ofstream address_trace_;
-#endif  // ADDR_TRACE
+    EpochWriter epoch_writer_;
+    LiveStatsPublisher live_stats_;
+
+#ifdef PROFILE
+    ProfileClock profile_clock_;
+#endif  // PROFILE
 };
 
 // hmmm not sure this is the best naming...
@@ -71,12 +106,28 @@ class JedecDRAMSystem : public BaseDRAMSystem {
                     std::function<void(uint64_t)> write_callback);
     ~JedecDRAMSystem();
     bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const override;
+    bool WillAcceptSizedTransaction(uint64_t hex_addr, bool is_write,
+                                    uint32_t size) const override;
     bool AddTransaction(uint64_t hex_addr, bool is_write) override;
+    bool AddTransaction(uint64_t hex_addr, bool is_write,
+                        uint32_t source) override;
+    bool AddSizedTransaction(uint64_t hex_addr, bool is_write, uint32_t size,
+                             uint32_t source) override;
     void ClockTick() override;
+    void WarmTransaction(uint64_t hex_addr, bool is_write) override;
+    void FastForward(uint64_t cycles) override;
+    bool SaveState(CheckpointWriter &out) const override;
+    bool LoadState(CheckpointReader &in) override;
 
     std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clk) override; ////////////////// add for NMP core
 
-
+   private:
+    // requests spanning channels by request id, the number of channels
+    // each still has to hear from
+    std::unordered_map<uint64_t, int> split_requests_;
+    uint64_t next_request_id_;
+    std::vector<int> RequestChannels(uint64_t hex_addr, uint32_t size) const;
+    bool RequestDone(uint64_t request_id);
 };
 
 // Model a memorysystem with an infinite bandwidth and a fixed latency (possibly
@@ -94,7 +145,10 @@ class IdealDRAMSystem : public BaseDRAMSystem {
     };
     bool AddTransaction(uint64_t hex_addr, bool is_write) override;
     void ClockTick() override;
-    
+    void WarmTransaction(uint64_t hex_addr, bool is_write) override {}
+    void FastForward(uint64_t cycles) override { clk_ += cycles; }
+    bool SaveState(CheckpointWriter &out) const override;
+    bool LoadState(CheckpointReader &in) override;
 
    private:
     int latency_;
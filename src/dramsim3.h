@@ -2,18 +2,33 @@
 #define __MEMORY_SYSTEM__H
 
 #include <functional>
+#include <map>
 #include <string>
 
 namespace dramsim3 {
 
+// defined in simple_stats.h
+struct StatsSnapshot;
+
 // This should be the interface class that deals with CPU
 class MemorySystem {
    public:
     MemorySystem(const std::string &config_file, const std::string &output_dir,
                  std::function<void(uint64_t)> read_callback,
                  std::function<void(uint64_t)> write_callback);
+    // config values keyed by "section.key" take precedence over the file
+    MemorySystem(const std::string &config_file, const std::string &output_dir,
+                 const std::map<std::string, std::string> &config_overrides,
+                 std::function<void(uint64_t)> read_callback,
+                 std::function<void(uint64_t)> write_callback);
     ~MemorySystem();
     void ClockTick();
+    // Hosts running in their own clock domain register their frequency
+    // once and then tick in host cycles, the DRAM clock (derived from tCK)
+    // is advanced as many times as it is due
+    void SetHostFrequency(double host_freq_mhz);
+    void Tick();
+    void AdvanceHostCycles(uint64_t host_cycles);
     void RegisterCallbacks(std::function<void(uint64_t)> read_callback,
                            std::function<void(uint64_t)> write_callback);
     double GetTCK() const;
@@ -22,9 +37,43 @@ class MemorySystem {
     int GetQueueSize() const;
     void PrintStats() const;
     void ResetStats();
+    // headline stats totals so far, see StatsSnapshot
+    StatsSnapshot GetStatsSnapshot() const;
+    // Region of interest: stats between the markers are also printed as a
+    // separate "phases" section per name. Beginning a region ends the open
+    // one, markers are recorded in the address trace (addr_trace = true).
+    void BeginROI(const std::string &name);
+    void EndROI();
+
+    // Save/restore the complete simulator state (queues, bank states,
+    // refresh counters and stats) so that one warmed up state can be
+    // reused by many runs with the same DRAM organization.
+    // Callbacks are not part of the state and have to be registered again
+    bool SaveCheckpoint(const std::string &file_name) const;
+    bool LoadCheckpoint(const std::string &file_name);
+
+    // Fast-forward (functional warm-up) mode: requests only update the
+    // open rows and the write buffer and complete on the next tick, cycles
+    // are only counted. Detailed simulation resumes after cycle_marker
+    // DRAM cycles or request_marker requests (0 means no marker), or
+    // when StopFastForward() is called.
+    void StartFastForward(uint64_t cycle_marker, uint64_t request_marker);
+    void StopFastForward();
+    bool IsFastForwarding() const;
 
     bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const;
     bool AddTransaction(uint64_t hex_addr, bool is_write);
+    // the tag is recorded in the address trace (addr_trace = true) and is
+    // the source id the command schedulers see (see num_sources)
+    bool AddTransaction(uint64_t hex_addr, bool is_write, uint32_t tag);
+    // requests of size bytes are split into one column burst per
+    // request_size_bytes they touch and called back once all are done,
+    // smaller ones take a single (on DDR3/DDR4 chopped) burst
+    bool WillAcceptSizedTransaction(uint64_t hex_addr, bool is_write,
+                                    uint32_t size) const;
+    bool AddSizedTransaction(uint64_t hex_addr, bool is_write, uint32_t size);
+    bool AddSizedTransaction(uint64_t hex_addr, bool is_write, uint32_t size,
+                             uint32_t tag);
 };
 
 MemorySystem* GetMemorySystem(const std::string &config_file, const std::string &output_dir,
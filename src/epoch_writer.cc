@@ -0,0 +1,170 @@
+#include "epoch_writer.h"
+
+#include <chrono>
+#include <map>
+
+namespace dramsim3 {
+
+namespace {
+// large enough that a typical epoch of all channels is one write
+const size_t kEpochBufferSize = 1 << 20;
+
+// pending epochs of all channels, the producer waits when it is full
+const size_t kRingSize = 256;
+
+// vector and histogram stats are nested objects, CSV columns are flattened
+// to "name.index", lists (e.g. hot rows) the same way
+void Flatten(const nlohmann::json& j, const std::string& prefix,
+             std::map<std::string, std::string>& columns) {
+    size_t index = 0;
+    for (auto it = j.begin(); it != j.end(); ++it, ++index) {
+        std::string key = j.is_array() ? std::to_string(index) : it.key();
+        std::string name = prefix.empty() ? key : prefix + "." + key;
+        if (it.value().is_structured()) {
+            Flatten(it.value(), name, columns);
+        } else {
+            columns[name] = it.value().dump();
+        }
+    }
+}
+}  // namespace
+
+EpochWriter::EpochWriter(const Config& config)
+    : config_(config),
+      buffer_(kEpochBufferSize),
+      num_records_(0),
+      head_(0),
+      tail_(0),
+      stop_(false) {}
+
+EpochWriter::~EpochWriter() { Close(); }
+
+void EpochWriter::Submit(std::function<void()> task) {
+    if (!config_.async_stats) {
+        task();
+        return;
+    }
+    if (!worker_.joinable()) {
+        ring_.resize(kRingSize);
+        stop_.store(false);
+        worker_ = std::thread(&EpochWriter::WorkerLoop, this);
+    }
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    while (tail - head_.load(std::memory_order_acquire) >= ring_.size()) {
+        std::this_thread::yield();
+    }
+    ring_[tail % ring_.size()] = std::move(task);
+    tail_.store(tail + 1, std::memory_order_release);
+}
+
+void EpochWriter::WorkerLoop() {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    while (true) {
+        if (head == tail_.load(std::memory_order_acquire)) {
+            // only quit once everything submitted before the stop is done
+            if (stop_.load(std::memory_order_acquire) &&
+                head == tail_.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        auto& task = ring_[head % ring_.size()];
+        task();
+        task = nullptr;
+        head++;
+        head_.store(head, std::memory_order_release);
+    }
+}
+
+void EpochWriter::Flush() {
+    if (worker_.joinable()) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        while (head_.load(std::memory_order_acquire) != tail) {
+            std::this_thread::yield();
+        }
+    }
+    if (!out_.is_open()) {
+        return;
+    }
+    if (config_.epoch_format == "json") {
+        // close the array on disk, the next record overwrites the bracket
+        out_ << "]";
+        out_.flush();
+        out_.seekp(-1, std::ios_base::cur);
+    } else {
+        out_.flush();
+    }
+}
+
+void EpochWriter::StopWorker() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    stop_.store(true, std::memory_order_release);
+    worker_.join();
+}
+
+void EpochWriter::Open() {
+    // the buffer has to be installed before the file is opened
+    out_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+    out_.open(config_.epoch_stats_name, std::ofstream::out);
+    if (config_.epoch_format == "json") {
+        out_ << "[";
+    }
+}
+
+void EpochWriter::Write(const nlohmann::json& record) {
+    if (!out_.is_open()) {
+        Open();
+    }
+    if (config_.epoch_format == "csv") {
+        WriteCSV(record);
+    } else if (config_.epoch_format == "ndjson") {
+        out_ << record << "\n";
+    } else {
+        if (num_records_ > 0) {
+            out_ << ",\n";
+        }
+        out_ << record;
+    }
+    num_records_++;
+}
+
+void EpochWriter::WriteCSV(const nlohmann::json& record) {
+    std::map<std::string, std::string> columns;
+    Flatten(record, "", columns);
+    if (csv_columns_.empty()) {
+        for (const auto& it : columns) {
+            if (!csv_columns_.empty()) {
+                out_ << ",";
+            }
+            out_ << it.first;
+            csv_columns_.push_back(it.first);
+        }
+        out_ << "\n";
+    }
+    for (size_t i = 0; i < csv_columns_.size(); i++) {
+        if (i > 0) {
+            out_ << ",";
+        }
+        auto it = columns.find(csv_columns_[i]);
+        if (it != columns.end()) {
+            out_ << it->second;
+        }
+    }
+    out_ << "\n";
+}
+
+void EpochWriter::Close() {
+    StopWorker();
+    if (!out_.is_open()) {
+        return;
+    }
+    if (config_.epoch_format == "json") {
+        out_ << "]";
+    }
+    out_.close();
+}
+
+}  // namespace dramsim3
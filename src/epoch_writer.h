@@ -0,0 +1,62 @@
+#ifndef __EPOCH_WRITER_H
+#define __EPOCH_WRITER_H
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "configuration.h"
+#include "json.hpp"
+
+namespace dramsim3 {
+
+// Buffered writer for per-channel epoch stats, owned by the memory system
+// and kept open for the whole simulation. Depending on epoch_format each
+// record becomes an element of a JSON array, one line of NDJSON or one CSV
+// row, the latter two can be streamed by tools while the simulation runs.
+//
+// With async_stats the work submitted each epoch (deriving and formatting
+// the stats, then writing them) runs on a background thread. Tasks are
+// passed through a single-producer single-consumer ring so the simulation
+// thread never takes a lock, it only spins if the exporter falls behind.
+class EpochWriter {
+   public:
+    explicit EpochWriter(const Config& config);
+    ~EpochWriter();
+    // run a task now, or on the export thread with async_stats, tasks run
+    // in the order they are submitted
+    void Submit(std::function<void()> task);
+    void Write(const nlohmann::json& record);
+    // wait for all submitted tasks to finish and leave a complete file,
+    // later records are still appended to it
+    void Flush();
+    // finish pending tasks and terminate the output, nothing is written if
+    // there were no records
+    void Close();
+
+   private:
+    const Config& config_;
+    std::ofstream out_;
+    std::vector<char> buffer_;
+    uint64_t num_records_;
+    // CSV column order is fixed by the first record
+    std::vector<std::string> csv_columns_;
+
+    // export thread, started with the first submitted task
+    std::thread worker_;
+    std::vector<std::function<void()> > ring_;
+    std::atomic<uint64_t> head_;  // next task to run, owned by the worker
+    std::atomic<uint64_t> tail_;  // next free slot, owned by the producer
+    std::atomic<bool> stop_;
+
+    void Open();
+    void WriteCSV(const nlohmann::json& record);
+    void WorkerLoop();
+    void StopWorker();
+};
+
+}  // namespace dramsim3
+#endif
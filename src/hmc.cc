@@ -297,6 +297,7 @@ HMCMemorySystem::HMCMemorySystem(Config &config, const std::string &output_dir,
 }
 
 HMCMemorySystem::~HMCMemorySystem() {
+    epoch_writer_.Close();
     for (auto &&vault_ptr : ctrls_) {
         delete (vault_ptr);
     }
@@ -563,6 +564,9 @@ void HMCMemorySystem::DRAMClockTick() {
     if (clk_ % config_.epoch_period == 0) {
         PrintEpochStats();
     }
+    if (config_.live_stats && clk_ % config_.live_stats_period == 0) {
+        PublishLiveStats();
+    }
     return;
 }
 
@@ -636,6 +640,16 @@ void HMCMemorySystem::VaultCallback(uint64_t req_id) {
 
 
 
+bool HMCMemorySystem::SaveState(CheckpointWriter &out) const {
+    std::cerr << "Checkpointing is not supported for HMC!" << std::endl;
+    return false;
+}
+
+bool HMCMemorySystem::LoadState(CheckpointReader &in) {
+    std::cerr << "Checkpointing is not supported for HMC!" << std::endl;
+    return false;
+}
+
 ///////////////////////// add for MNP core
 std::pair<uint64_t, int> HMCMemorySystem::ReturnDoneTrans(uint64_t clk) {
     return std::make_pair(static_cast<uint64_t>(-1), -1);
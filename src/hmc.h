@@ -112,6 +112,9 @@ class HMCMemorySystem : public BaseDRAMSystem {
     // we can unify them as one but then we'll have to convert all the
     // slow dram time units to faster logic units...
     void ClockTick() override;
+    // the xbar holds raw pointers to in-flight packets, not supported yet
+    bool SaveState(CheckpointWriter& out) const override;
+    bool LoadState(CheckpointReader& in) override;
 
     std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clk) override; ///////////////// add for NMP core
 
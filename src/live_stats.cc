@@ -0,0 +1,117 @@
+#include "live_stats.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+
+#include "common.h"
+
+namespace dramsim3 {
+
+namespace {
+const char kLiveStatsMagic[8] = {'D', 'S', '3', 'L', 'I', 'V', 'E', '\0'};
+
+const int kReadRetries = 1000;
+}  // namespace
+
+LiveStatsPublisher::LiveStatsPublisher() : segment_(nullptr) {}
+
+LiveStatsPublisher::~LiveStatsPublisher() { Close(); }
+
+void LiveStatsPublisher::Open(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0 || ftruncate(fd, sizeof(LiveStatsSegment)) != 0) {
+        std::cerr << "Cannot create shared memory segment " << name
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    void* addr = mmap(nullptr, sizeof(LiveStatsSegment),
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Cannot map shared memory segment " << name << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    name_ = name;
+    segment_ = static_cast<LiveStatsSegment*>(addr);
+    // the magic goes in last so readers never see a half initialized header
+    std::memset(&segment_->data, 0, sizeof(segment_->data));
+    segment_->version = kLiveStatsVersion;
+    segment_->pid = getpid();
+    segment_->seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(segment_->magic, kLiveStatsMagic, sizeof(kLiveStatsMagic));
+}
+
+void LiveStatsPublisher::Publish(const LiveStatsData& data) {
+    uint64_t seq = segment_->seq.load(std::memory_order_relaxed);
+    segment_->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&segment_->data, &data, sizeof(data));
+    segment_->seq.store(seq + 2, std::memory_order_release);
+}
+
+void LiveStatsPublisher::Close() {
+    if (segment_ == nullptr) {
+        return;
+    }
+    LiveStatsData data = segment_->data;
+    data.finished = 1;
+    Publish(data);
+    munmap(segment_, sizeof(LiveStatsSegment));
+    shm_unlink(name_.c_str());
+    segment_ = nullptr;
+}
+
+LiveStatsReader::LiveStatsReader() : segment_(nullptr) {}
+
+LiveStatsReader::~LiveStatsReader() {
+    if (segment_ != nullptr) {
+        munmap(const_cast<LiveStatsSegment*>(segment_),
+               sizeof(LiveStatsSegment));
+    }
+}
+
+bool LiveStatsReader::Open(const std::string& name) {
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    void* addr =
+        mmap(nullptr, sizeof(LiveStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    const auto* segment = static_cast<const LiveStatsSegment*>(addr);
+    if (std::memcmp(segment->magic, kLiveStatsMagic,
+                    sizeof(kLiveStatsMagic)) != 0 ||
+        segment->version != kLiveStatsVersion) {
+        munmap(addr, sizeof(LiveStatsSegment));
+        return false;
+    }
+    segment_ = segment;
+    return true;
+}
+
+bool LiveStatsReader::Read(LiveStatsData& data) const {
+    for (int i = 0; i < kReadRetries; i++) {
+        uint64_t before = segment_->seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        std::memcpy(&data, &segment_->data, sizeof(data));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = segment_->seq.load(std::memory_order_relaxed);
+        if (before == after) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t LiveStatsReader::Pid() const { return segment_->pid; }
+
+}  // namespace dramsim3
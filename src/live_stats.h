@@ -0,0 +1,82 @@
+#ifndef __LIVE_STATS_H
+#define __LIVE_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace dramsim3 {
+
+const int kLiveStatsMaxChannels = 64;
+const uint32_t kLiveStatsVersion = 1;
+
+struct LiveChannelStats {
+    uint64_t num_reads_done;
+    uint64_t num_writes_done;
+    uint32_t queue_usage;    // commands in the command queues
+    uint32_t pending_reads;  // reads accepted but not returned
+};
+
+// Everything the viewer sees, copied as a whole under the sequence lock
+struct LiveStatsData {
+    uint64_t clk;
+    uint64_t wall_time_ms;  // wall clock of the update, to spot stalls
+    uint32_t num_channels;
+    uint32_t finished;
+    double tCK;
+    double bandwidth;  // GB/s since the start
+    double row_hit_rate;
+    double average_read_latency;  // cycles
+    double p50_read_latency;
+    double p99_read_latency;
+    uint64_t num_reads_done;
+    uint64_t num_writes_done;
+    LiveChannelStats channels[kLiveStatsMaxChannels];
+};
+
+// Layout of the shared memory segment. seq is odd while the simulator is
+// writing, readers retry until they see the same even value before and
+// after copying the data.
+struct LiveStatsSegment {
+    char magic[8];
+    uint32_t version;
+    uint32_t pid;
+    std::atomic<uint64_t> seq;
+    LiveStatsData data;
+};
+
+// Simulator side, owns the segment and removes it when done
+class LiveStatsPublisher {
+   public:
+    LiveStatsPublisher();
+    ~LiveStatsPublisher();
+    void Open(const std::string& name);
+    bool IsOpen() const { return segment_ != nullptr; }
+    void Publish(const LiveStatsData& data);
+    // marks the run as finished and unlinks the segment, readers that
+    // already mapped it keep the last values
+    void Close();
+
+   private:
+    std::string name_;
+    LiveStatsSegment* segment_;
+};
+
+// Viewer side, read only mapping
+class LiveStatsReader {
+   public:
+    LiveStatsReader();
+    ~LiveStatsReader();
+    // false if there is no such segment or it is not a live stats segment
+    bool Open(const std::string& name);
+    // consistent copy of the latest update, false if the writer kept
+    // updating for too long
+    bool Read(LiveStatsData& data) const;
+    uint32_t Pid() const;
+
+   private:
+    const LiveStatsSegment* segment_;
+};
+
+}  // namespace dramsim3
+#endif
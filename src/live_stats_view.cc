@@ -0,0 +1,110 @@
+// Watches the live stats of a running simulation, see live_stats in the
+// [other] config section
+#include <signal.h>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include "./../ext/headers/args.hxx"
+#include "fmt/format.h"
+#include "live_stats.h"
+
+using namespace dramsim3;
+
+namespace {
+uint64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void PrintUpdate(const LiveStatsData& data, double cycles_per_sec,
+                 const std::string& status) {
+    std::cout << fmt::format(
+        "clk {:>12} ({:>8.3f} Mcyc/s) reads {:>10} writes {:>10} "
+        "bw {:>7.2f} GB/s hit {:>5.1f}% lat avg {:>6.1f} p50 {:>5.0f} "
+        "p99 {:>5.0f} queue",
+        data.clk, cycles_per_sec / 1e6, data.num_reads_done,
+        data.num_writes_done, data.bandwidth, data.row_hit_rate * 100,
+        data.average_read_latency, data.p50_read_latency,
+        data.p99_read_latency);
+    for (uint32_t i = 0; i < data.num_channels; i++) {
+        std::cout << " " << data.channels[i].queue_usage;
+    }
+    if (!status.empty()) {
+        std::cout << "  " << status;
+    }
+    std::cout << std::endl;
+}
+}  // namespace
+
+int main(int argc, const char** argv) {
+    args::ArgumentParser parser(
+        "Live stats viewer.",
+        "Example: \n./build/dramsim3live /dramsim3_12345 -i 2000");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::ValueFlag<int> interval_arg(parser, "interval",
+                                      "Refresh interval in ms, default 1000",
+                                      {'i', "interval"}, 1000);
+    args::ValueFlag<int> stall_arg(
+        parser, "stall",
+        "Report a stall after this many seconds without updates, default 60",
+        {'s', "stall"}, 60);
+    args::Flag once_arg(parser, "once", "Print one update and exit",
+                        {"once"});
+    args::Positional<std::string> name_arg(
+        parser, "name", "Shared memory segment, printed by the simulator");
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string name = args::get(name_arg);
+    LiveStatsReader reader;
+    if (name.empty() || !reader.Open(name)) {
+        std::cerr << "Cannot open live stats " << name << std::endl;
+        return 1;
+    }
+
+    uint64_t stall_ms = args::get(stall_arg) * 1000ULL;
+    LiveStatsData prev;
+    bool has_prev = false;
+    double cycles_per_sec = 0.0;
+    while (true) {
+        LiveStatsData data;
+        if (!reader.Read(data)) {
+            std::cerr << "Could not get a consistent snapshot" << std::endl;
+            return 1;
+        }
+        // the rate only changes when the simulator published again
+        if (has_prev && data.wall_time_ms > prev.wall_time_ms) {
+            cycles_per_sec = (data.clk - prev.clk) * 1000.0 /
+                             (data.wall_time_ms - prev.wall_time_ms);
+        }
+        std::string status;
+        if (data.finished) {
+            status = "finished";
+        } else if (kill(reader.Pid(), 0) != 0 && errno == ESRCH) {
+            status = "simulator exited";
+        } else if (data.wall_time_ms > 0 &&
+                   NowMs() - data.wall_time_ms > stall_ms) {
+            status = "STALLED";
+        }
+        PrintUpdate(data, cycles_per_sec, status);
+        if (args::get(once_arg) || data.finished ||
+            status == "simulator exited") {
+            break;
+        }
+        prev = data;
+        has_prev = true;
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(args::get(interval_arg)));
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <iostream>
 #include "./../ext/headers/args.hxx"
 #include "cpu.h"
+#include "sampling.h"
 
 using namespace dramsim3;
 
@@ -26,6 +27,25 @@ int main(int argc, const char **argv) {
         parser, "trace",
         "Trace file, setting this option will ignore -s option",
         {'t', "trace"});
+    args::ValueFlag<uint64_t> sample_period_arg(
+        parser, "sample_period",
+        "Sample the trace once every this many requests (needs -t)",
+        {"sample-period"}, 0);
+    args::ValueFlag<uint64_t> sample_window_arg(
+        parser, "sample_window", "Measured requests per sample",
+        {"sample-window"}, 1000);
+    args::ValueFlag<uint64_t> sample_warmup_arg(
+        parser, "sample_warmup",
+        "Detailed but unmeasured requests before each sample",
+        {"sample-warmup"}, 2000);
+    args::ValueFlag<double> sample_error_arg(
+        parser, "sample_error",
+        "Stop once all 95% confidence intervals are within this relative "
+        "error, 0 samples the whole trace",
+        {"sample-error"}, 0.02);
+    args::ValueFlag<int> sample_min_arg(
+        parser, "sample_min", "Minimum number of samples before stopping",
+        {"sample-min"}, 30);
     args::Positional<std::string> config_arg(
         parser, "config", "The config file name (mandatory)");
 
@@ -51,6 +71,23 @@ int main(int argc, const char **argv) {
     std::string trace_file = args::get(trace_file_arg);
     std::string stream_type = args::get(stream_arg);
 
+    if (args::get(sample_period_arg) > 0) {
+        if (trace_file.empty()) {
+            std::cerr << "Sampling needs a trace file!" << std::endl;
+            return 1;
+        }
+        SamplingParams params;
+        params.period = args::get(sample_period_arg);
+        params.window = args::get(sample_window_arg);
+        params.warmup = args::get(sample_warmup_arg);
+        params.target_error = args::get(sample_error_arg);
+        params.min_samples = args::get(sample_min_arg);
+        SampledTraceCPU sampler(config_file, output_dir, trace_file, params);
+        sampler.Run();
+        sampler.PrintStats();
+        return 0;
+    }
+
     CPU *cpu;
     if (!trace_file.empty()) {
         cpu = new TraceBasedCPU(config_file, output_dir, trace_file);
@@ -0,0 +1,335 @@
+// Address mapping auto-tuner: screens every field order (plus XOR bank-hash
+// variants) of a config with a quick bank model over a trace, then simulates
+// the finalists and writes out the best mapping
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <thread>
+#include "./../ext/headers/args.hxx"
+#include "configuration.h"
+#include "fmt/format.h"
+#include "trace_runner.h"
+
+using namespace dramsim3;
+
+namespace {
+struct Candidate {
+    std::string name;
+    // [system] keys, empty hashes clear the ones of the base config
+    std::map<std::string, std::string> settings;
+    // quick model
+    double est_cycles;
+    double est_row_hit_rate;
+    double est_bank_spread;
+    // detailed simulation, finalists only
+    bool simulated;
+    TraceRunResult result;
+
+    std::map<std::string, std::string> Overrides() const {
+        std::map<std::string, std::string> overrides;
+        for (const auto& it : settings) {
+            overrides["system." + it.first] = it.second;
+        }
+        return overrides;
+    }
+};
+
+Candidate MakeCandidate(const std::string& name,
+                        const std::string& address_mapping) {
+    Candidate candidate;
+    candidate.name = name;
+    candidate.settings = {{"address_mapping", address_mapping},
+                          {"ch_hash", ""},
+                          {"ra_hash", ""},
+                          {"bg_hash", ""},
+                          {"ba_hash", ""}};
+    candidate.simulated = false;
+    return candidate;
+}
+
+// the mapping of the config as it is, address_hash reads "key=value;..."
+Candidate BaseCandidate(const Config& config) {
+    Candidate candidate = MakeCandidate("base", config.address_mapping);
+    for (const auto& entry : StringSplit(config.address_hash, ';')) {
+        auto eq = entry.find('=');
+        if (eq != std::string::npos) {
+            candidate.settings[entry.substr(0, eq)] = entry.substr(eq + 1);
+        }
+    }
+    return candidate;
+}
+
+// every order of the fields that have bits, fields without bits go first
+// since they cannot change the mapping
+std::vector<std::string> FieldOrders(const Config& config) {
+    std::map<std::string, int> widths = {
+        {"ch", LogBase2(config.channels)},  {"ra", LogBase2(config.ranks)},
+        {"bg", LogBase2(config.bankgroups)}, {"ba", LogBase2(config.banks_per_group)},
+        {"ro", LogBase2(config.rows)},      {"co", 1}};
+    std::string prefix;
+    std::vector<std::string> fields;
+    for (const auto& it : widths) {
+        if (it.second == 0) {
+            prefix += it.first;
+        } else {
+            fields.push_back(it.first);
+        }
+    }
+    std::vector<std::string> orders;
+    std::sort(fields.begin(), fields.end());
+    do {
+        std::string order = prefix;
+        for (const auto& field : fields) {
+            order += field;
+        }
+        orders.push_back(order);
+    } while (std::next_permutation(fields.begin(), fields.end()));
+    return orders;
+}
+
+// XOR bank and bankgroup bits with the low row bits so that a row stride
+// walks the banks, config has the plain layout of the candidate
+void SetBankHash(const Config& config, Candidate& candidate) {
+    int row_bit = config.ro_pos + config.shift_bits;
+    auto hash = [&](int pos, int width) {
+        std::string spec;
+        for (int i = 0; i < width; i++) {
+            if (!spec.empty()) spec += ",";
+            spec += fmt::format("{}^{}", pos + config.shift_bits + i, row_bit++);
+        }
+        return spec;
+    };
+    candidate.settings["ba_hash"] =
+        hash(config.ba_pos, LogBase2(config.banks_per_group));
+    candidate.settings["bg_hash"] =
+        hash(config.bg_pos, LogBase2(config.bankgroups));
+}
+
+// Replays the first max_requests requests against an open page bank model:
+// within a window of as many requests as the transaction queues hold, banks
+// work in parallel but each pays tCCD on a row hit and tRP+tRCD on a miss,
+// and each channel moves one burst at a time
+void Screen(const Config& config, const std::vector<Transaction>& trace,
+            size_t max_requests, Candidate& candidate) {
+    int num_banks = config.channels * config.ranks * config.banks;
+    size_t window = static_cast<size_t>(config.trans_queue_size) *
+                    config.channels;
+    int hit_cost = std::max(config.burst_cycle, config.tCCD_L);
+    int closed_cost = config.tRCD + config.burst_cycle;
+    int conflict_cost = config.tRP + closed_cost;
+    std::vector<int> open_rows(num_banks, -1);
+    std::vector<uint64_t> bank_busy(num_banks, 0);
+    std::vector<uint64_t> bus_busy(config.channels, 0);
+    std::set<int> touched;
+    uint64_t hits = 0, cycles = 0, spread = 0, windows = 0;
+    size_t num_requests = std::min(max_requests, trace.size());
+    for (size_t i = 0; i < num_requests; i++) {
+        auto addr = config.AddressMapping(trace[i].addr);
+        int bank = ((addr.channel * config.ranks + addr.rank) *
+                        config.bankgroups +
+                    addr.bankgroup) *
+                       config.banks_per_group +
+                   addr.bank;
+        if (open_rows[bank] == addr.row) {
+            bank_busy[bank] += hit_cost;
+            hits++;
+        } else {
+            bank_busy[bank] += open_rows[bank] < 0 ? closed_cost : conflict_cost;
+            open_rows[bank] = addr.row;
+        }
+        bus_busy[addr.channel] += config.burst_cycle;
+        touched.insert(bank);
+        if ((i + 1) % window == 0 || i + 1 == num_requests) {
+            cycles += std::max(
+                *std::max_element(bank_busy.begin(), bank_busy.end()),
+                *std::max_element(bus_busy.begin(), bus_busy.end()));
+            spread += touched.size();
+            windows++;
+            std::fill(bank_busy.begin(), bank_busy.end(), 0);
+            std::fill(bus_busy.begin(), bus_busy.end(), 0);
+            touched.clear();
+        }
+    }
+    candidate.est_cycles = cycles;
+    candidate.est_row_hit_rate =
+        num_requests == 0 ? 0.0 : static_cast<double>(hits) / num_requests;
+    candidate.est_bank_spread =
+        windows == 0 ? 0.0
+                     : static_cast<double>(spread) / windows /
+                           std::min(window, static_cast<size_t>(num_banks));
+}
+
+bool BetterResult(const TraceRunResult& a, const TraceRunResult& b) {
+    if (a.stats.Bandwidth() != b.stats.Bandwidth()) {
+        return a.stats.Bandwidth() > b.stats.Bandwidth();
+    }
+    return a.stats.AverageReadLatency() < b.stats.AverageReadLatency();
+}
+}  // namespace
+
+int main(int argc, const char** argv) {
+    args::ArgumentParser parser(
+        "DRAMSim3 address mapping tuner, screens all field orders and XOR "
+        "bank-hash variants of a config on a trace, simulates the most "
+        "promising ones and writes the best mapping as an ini snippet.",
+        "Examples: \n"
+        "./build/dramsim3maptune configs/DDR4_8Gb_x8_2400.ini -t trace.txt "
+        "-o maptune_out");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::ValueFlag<std::string> trace_file_arg(
+        parser, "trace", "Trace file (mandatory)", {'t', "trace"});
+    args::ValueFlag<std::string> output_dir_arg(
+        parser, "output_dir", "Output directory, one sub-directory per run",
+        {'o', "output-dir"}, ".");
+    args::ValueFlag<uint64_t> num_cycles_arg(
+        parser, "num_cycles", "Cycle limit per run, 0 runs until drained",
+        {'c', "cycles"}, 0);
+    args::ValueFlag<size_t> screen_requests_arg(
+        parser, "screen_requests", "Requests the quick model looks at",
+        {"screen-requests"}, 1000000);
+    args::ValueFlag<int> finalists_arg(
+        parser, "finalists", "Candidates simulated in detail",
+        {'n', "finalists"}, 8);
+    args::ValueFlag<int> threads_arg(parser, "threads",
+                                     "Number of threads, 0 uses all cores",
+                                     {'j', "threads"}, 0);
+    args::Positional<std::string> config_arg(parser, "config",
+                                             "The base config file");
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string config_file = args::get(config_arg);
+    std::string trace_file = args::get(trace_file_arg);
+    if (trace_file.empty() || config_file.empty()) {
+        std::cerr << parser;
+        return 1;
+    }
+    std::string output_dir = args::get(output_dir_arg);
+    uint64_t max_cycles = args::get(num_cycles_arg);
+    int num_finalists = std::max(1, args::get(finalists_arg));
+    int num_threads = args::get(threads_arg);
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    mkdir(output_dir.c_str(), 0755);
+
+    Config base_config(config_file, output_dir);
+    // the base mapping always runs for reference
+    std::vector<Candidate> candidates = {BaseCandidate(base_config)};
+    std::vector<bool> bank_hashed = {false};
+    for (const auto& order : FieldOrders(base_config)) {
+        candidates.push_back(MakeCandidate(order, order));
+        bank_hashed.push_back(false);
+        candidates.push_back(MakeCandidate(order + "_xor", order));
+        bank_hashed.push_back(true);
+    }
+
+    const std::vector<Transaction> trace = LoadTrace(trace_file);
+    std::cout << fmt::format("Screening {} mappings over {} requests on {} "
+                             "threads",
+                             candidates.size(), trace.size(), num_threads)
+              << std::endl;
+    RunParallel(candidates.size(), num_threads, [&](int i) {
+        auto& candidate = candidates[i];
+        if (bank_hashed[i]) {
+            Config plain(config_file, output_dir, candidate.Overrides());
+            SetBankHash(plain, candidate);
+        }
+        Config config(config_file, output_dir, candidate.Overrides());
+        Screen(config, trace, args::get(screen_requests_arg), candidate);
+    });
+
+    std::vector<int> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return candidates[a].est_cycles < candidates[b].est_cycles;
+    });
+    std::vector<int> finalists(order.begin(),
+                               order.begin() + std::min(num_finalists,
+                                                        static_cast<int>(
+                                                            order.size())));
+    if (std::find(finalists.begin(), finalists.end(), 0) == finalists.end()) {
+        finalists.push_back(0);
+    }
+
+    std::cout << fmt::format("Simulating {} finalists", finalists.size())
+              << std::endl;
+    RunParallel(finalists.size(), num_threads, [&](int i) {
+        auto& candidate = candidates[finalists[i]];
+        std::string run_dir = output_dir + "/" + candidate.name;
+        mkdir(run_dir.c_str(), 0755);
+        candidate.result = RunTrace(config_file, run_dir,
+                                    candidate.Overrides(), trace, max_cycles);
+        candidate.simulated = true;
+    });
+
+    int best = finalists[0];
+    for (int i : finalists) {
+        if (BetterResult(candidates[i].result, candidates[best].result)) {
+            best = i;
+        }
+    }
+
+    std::string csv_name = output_dir + "/maptune.csv";
+    std::ofstream csv(csv_name);
+    csv << "name,address_mapping,bg_hash,ba_hash,est_cycles,est_row_hit_rate,"
+           "est_bank_spread,simulated,cycles,finished,bandwidth,row_hit_rate,"
+           "average_read_latency"
+        << std::endl;
+    for (int i : order) {
+        const auto& candidate = candidates[i];
+        const auto& stats = candidate.result.stats;
+        const auto& settings = candidate.settings;
+        csv << fmt::format("{},{},\"{}\",\"{}\",{},{},{},{}", candidate.name,
+                           settings.at("address_mapping"),
+                           settings.at("bg_hash"), settings.at("ba_hash"),
+                           candidate.est_cycles,
+                           candidate.est_row_hit_rate,
+                           candidate.est_bank_spread,
+                           candidate.simulated ? 1 : 0);
+        if (candidate.simulated) {
+            csv << fmt::format(",{},{},{},{},{}", candidate.result.cycles,
+                               candidate.result.finished ? 1 : 0,
+                               stats.Bandwidth(), stats.RowHitRate(),
+                               stats.AverageReadLatency());
+        } else {
+            csv << ",,,,,";
+        }
+        csv << std::endl;
+    }
+
+    const auto& winner = candidates[best];
+    std::string ini_name = output_dir + "/best_mapping.ini";
+    std::ofstream ini(ini_name);
+    ini << fmt::format("; best of {} mappings for {}\n", candidates.size(),
+                       trace_file)
+        << fmt::format("; bandwidth {:.3f} GB/s, average read latency {:.2f} "
+                       "cycles, row hit rate {:.3f}\n",
+                       winner.result.stats.Bandwidth(),
+                       winner.result.stats.AverageReadLatency(),
+                       winner.result.stats.RowHitRate())
+        << "[system]\n";
+    for (const auto& it : winner.settings) {
+        if (!it.second.empty()) {
+            ini << it.first << " = " << it.second << "\n";
+        }
+    }
+    std::cout << fmt::format("Best mapping {} ({:.3f} GB/s), written to {}",
+                             winner.name, winner.result.stats.Bandwidth(),
+                             ini_name)
+              << std::endl;
+    return 0;
+}
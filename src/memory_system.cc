@@ -1,12 +1,33 @@
 // this is memory_systems.cc
 #include "memory_system.h"
+#include "checkpoint.h"
+
+#include <algorithm>
 
 namespace dramsim3 {
 MemorySystem::MemorySystem(const std::string &config_file,
                            const std::string &output_dir,
                            std::function<void(uint64_t)> read_callback,
                            std::function<void(uint64_t)> write_callback)
-    : config_(new Config(config_file, output_dir)) {
+    : MemorySystem(config_file, output_dir,
+                   std::map<std::string, std::string>(), read_callback,
+                   write_callback) {}
+
+MemorySystem::MemorySystem(
+    const std::string &config_file, const std::string &output_dir,
+    const std::map<std::string, std::string> &config_overrides,
+    std::function<void(uint64_t)> read_callback,
+    std::function<void(uint64_t)> write_callback)
+    : config_(new Config(config_file, output_dir, config_overrides)),
+      host_clock_(1, 1),
+      addr_trace_(nullptr),
+      fast_forward_(false),
+      ff_cycles_(0),
+      ff_requests_(0),
+      ff_cycle_marker_(0),
+      ff_request_marker_(0),
+      read_callback_(read_callback),
+      write_callback_(write_callback) {
     // TODO: ideal memory type?
     if (config_->IsHMC()) {
         dram_system_ = new HMCMemorySystem(*config_, output_dir, read_callback,
@@ -15,14 +36,98 @@ MemorySystem::MemorySystem(const std::string &config_file,
         dram_system_ = new JedecDRAMSystem(*config_, output_dir, read_callback,
                                            write_callback);
     }
+    if (config_->warmup_cycles > 0 || config_->warmup_requests > 0) {
+        StartFastForward(config_->warmup_cycles, config_->warmup_requests);
+    }
+    if (config_->addr_trace) {
+        addr_trace_ = new AddrTraceWriter(config_->addr_trace_name);
+    }
 }
 
 MemorySystem::~MemorySystem() {
+    delete (addr_trace_);
     delete (dram_system_);
     delete (config_);
 }
 
-void MemorySystem::ClockTick() { dram_system_->ClockTick(); }
+void MemorySystem::ClockTick() {
+    if (!ff_returns_.empty()) {
+        ReturnWarmedRequests();
+    }
+    if (fast_forward_) {
+        FastForwardCycles(1);
+    } else {
+        dram_system_->ClockTick();
+    }
+}
+
+void MemorySystem::SetHostFrequency(double host_freq_mhz) {
+    host_clock_.SetClocks(host_freq_mhz, config_->tCK);
+}
+
+void MemorySystem::Tick() { AdvanceHostCycles(1); }
+
+void MemorySystem::AdvanceHostCycles(uint64_t host_cycles) {
+    uint64_t dram_cycles = host_clock_.AdvanceParent(host_cycles);
+    if (!ff_returns_.empty()) {
+        ReturnWarmedRequests();
+    }
+    // fast-forwarded cycles are skipped in one go
+    if (fast_forward_) {
+        uint64_t skipped = dram_cycles;
+        if (ff_cycle_marker_ > 0) {
+            skipped = std::min(dram_cycles, ff_cycle_marker_ - ff_cycles_);
+        }
+        FastForwardCycles(skipped);
+        dram_cycles -= skipped;
+    }
+    for (uint64_t i = 0; i < dram_cycles; i++) {
+        dram_system_->ClockTick();
+    }
+}
+
+void MemorySystem::StartFastForward(uint64_t cycle_marker,
+                                    uint64_t request_marker) {
+    if (config_->IsHMC()) {
+        std::cerr << "Fast-forward is not supported for HMC!" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    fast_forward_ = true;
+    ff_cycles_ = 0;
+    ff_requests_ = 0;
+    ff_cycle_marker_ = cycle_marker;
+    ff_request_marker_ = request_marker;
+}
+
+void MemorySystem::StopFastForward() {
+    if (!fast_forward_) {
+        return;
+    }
+    fast_forward_ = false;
+    dram_system_->FastForward(ff_cycles_);
+}
+
+bool MemorySystem::IsFastForwarding() const { return fast_forward_; }
+
+void MemorySystem::FastForwardCycles(uint64_t dram_cycles) {
+    ff_cycles_ += dram_cycles;
+    if (ff_cycle_marker_ > 0 && ff_cycles_ >= ff_cycle_marker_) {
+        StopFastForward();
+    }
+}
+
+void MemorySystem::ReturnWarmedRequests() {
+    // swap first, callbacks may add new requests
+    std::vector<std::pair<uint64_t, bool>> returns;
+    returns.swap(ff_returns_);
+    for (const auto &ret : returns) {
+        if (ret.second) {
+            write_callback_(ret.first);
+        } else {
+            read_callback_(ret.first);
+        }
+    }
+}
 
 double MemorySystem::GetTCK() const { return config_->tCK; }
 
@@ -35,22 +140,133 @@ int MemorySystem::GetQueueSize() const { return config_->trans_queue_size; }
 void MemorySystem::RegisterCallbacks(
     std::function<void(uint64_t)> read_callback,
     std::function<void(uint64_t)> write_callback) {
+    read_callback_ = read_callback;
+    write_callback_ = write_callback;
     dram_system_->RegisterCallbacks(read_callback, write_callback);
 }
 
 bool MemorySystem::WillAcceptTransaction(uint64_t hex_addr,
                                          bool is_write) const {
+    if (fast_forward_) {
+        return true;
+    }
     return dram_system_->WillAcceptTransaction(hex_addr, is_write);
 }
 
+bool MemorySystem::WillAcceptSizedTransaction(uint64_t hex_addr, bool is_write,
+                                              uint32_t size) const {
+    if (fast_forward_) {
+        return true;
+    }
+    return dram_system_->WillAcceptSizedTransaction(hex_addr, is_write, size);
+}
+
 bool MemorySystem::AddTransaction(uint64_t hex_addr, bool is_write) {
-    return dram_system_->AddTransaction(hex_addr, is_write);
+    return AddTransaction(hex_addr, is_write, 0);
+}
+
+bool MemorySystem::AddTransaction(uint64_t hex_addr, bool is_write,
+                                  uint32_t tag) {
+    return AddSizedTransaction(hex_addr, is_write, 0, tag);
+}
+
+bool MemorySystem::AddSizedTransaction(uint64_t hex_addr, bool is_write,
+                                       uint32_t size) {
+    return AddSizedTransaction(hex_addr, is_write, size, 0);
+}
+
+bool MemorySystem::AddSizedTransaction(uint64_t hex_addr, bool is_write,
+                                       uint32_t size, uint32_t tag) {
+    if (addr_trace_) {
+        // cycles skipped by fast-forward are only applied when it stops
+        uint64_t clk = dram_system_->GetClk() + (fast_forward_ ? ff_cycles_ : 0);
+        addr_trace_->Write(hex_addr, is_write, clk, tag);
+    }
+    if (fast_forward_) {
+        auto bursts = config_->BurstAddresses(hex_addr, size);
+        if (bursts.size() == 1) {
+            dram_system_->WarmTransaction(hex_addr, is_write);
+        } else {
+            for (auto addr : bursts) {
+                dram_system_->WarmTransaction(addr, is_write);
+            }
+        }
+        ff_returns_.push_back(std::make_pair(hex_addr, is_write));
+        ff_requests_++;
+        if (ff_request_marker_ > 0 && ff_requests_ >= ff_request_marker_) {
+            StopFastForward();
+        }
+        return true;
+    }
+    return dram_system_->AddSizedTransaction(hex_addr, is_write, size, tag);
 }
 
 void MemorySystem::PrintStats() const { dram_system_->PrintStats(); }
 
 void MemorySystem::ResetStats() { dram_system_->ResetStats(); }
 
+void MemorySystem::BeginROI(const std::string &name) {
+    if (addr_trace_) {
+        uint64_t clk = dram_system_->GetClk() + (fast_forward_ ? ff_cycles_ : 0);
+        addr_trace_->WriteMarker(TraceRecordType::ROI_BEGIN, name, clk);
+    }
+    dram_system_->BeginROI(name);
+}
+
+void MemorySystem::EndROI() {
+    if (addr_trace_) {
+        uint64_t clk = dram_system_->GetClk() + (fast_forward_ ? ff_cycles_ : 0);
+        addr_trace_->WriteMarker(TraceRecordType::ROI_END, "", clk);
+    }
+    dram_system_->EndROI();
+}
+
+StatsSnapshot MemorySystem::GetStatsSnapshot() const {
+    return dram_system_->GetStatsSnapshot();
+}
+
+bool MemorySystem::SaveCheckpoint(const std::string &file_name) const {
+    CheckpointWriter out(file_name);
+    if (!out.IsGood()) {
+        std::cerr << "Cannot open checkpoint file " << file_name << std::endl;
+        return false;
+    }
+    out.WriteHeader(*config_);
+    if (!dram_system_->SaveState(out)) {
+        return false;
+    }
+    host_clock_.SaveState(out);
+    out.Write(fast_forward_);
+    out.Write(ff_cycles_);
+    out.Write(ff_requests_);
+    out.Write(ff_cycle_marker_);
+    out.Write(ff_request_marker_);
+    out.Write(ff_returns_);
+    return out.IsGood();
+}
+
+bool MemorySystem::LoadCheckpoint(const std::string &file_name) {
+    CheckpointReader in(file_name);
+    if (!in.IsGood()) {
+        std::cerr << "Cannot open checkpoint file " << file_name << std::endl;
+        return false;
+    }
+    if (!in.ReadHeader(*config_)) {
+        return false;
+    }
+    if (!dram_system_->LoadState(in)) {
+        return false;
+    }
+    host_clock_.LoadState(in);
+    in.Read(fast_forward_);
+    in.Read(ff_cycles_);
+    in.Read(ff_requests_);
+    in.Read(ff_cycle_marker_);
+    in.Read(ff_request_marker_);
+    in.Read(ff_returns_);
+    return in.IsGood();
+}
+
 ///////////////////////// add for NMP core
 std::pair<uint64_t, int> MemorySystem::ReturnDoneTrans(uint64_t clk) {
     return dram_system_->ReturnDoneTrans(clk);
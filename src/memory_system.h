@@ -3,8 +3,12 @@
 #define __MEMORY_SYSTEM__H
 
 #include <functional>
+#include <map>
 #include <string>
+#include <vector>
 
+#include "addr_trace.h"
+#include "clock_domain.h"
 #include "configuration.h"
 #include "dram_system.h"
 #include "hmc.h"
@@ -17,8 +21,19 @@ class MemorySystem {
     MemorySystem(const std::string &config_file, const std::string &output_dir,
                  std::function<void(uint64_t)> read_callback,
                  std::function<void(uint64_t)> write_callback);
+    // config values keyed by "section.key" take precedence over the file
+    MemorySystem(const std::string &config_file, const std::string &output_dir,
+                 const std::map<std::string, std::string> &config_overrides,
+                 std::function<void(uint64_t)> read_callback,
+                 std::function<void(uint64_t)> write_callback);
     ~MemorySystem();
     void ClockTick();
+    // Hosts running in their own clock domain register their frequency
+    // once and then tick in host cycles, the DRAM clock (derived from tCK)
+    // is advanced as many times as it is due
+    void SetHostFrequency(double host_freq_mhz);
+    void Tick();
+    void AdvanceHostCycles(uint64_t host_cycles);
     void RegisterCallbacks(std::function<void(uint64_t)> read_callback,
                            std::function<void(uint64_t)> write_callback);
     double GetTCK() const;
@@ -27,6 +42,29 @@ class MemorySystem {
     int GetQueueSize() const;
     void PrintStats() const;
     void ResetStats();
+    // headline stats totals so far, see StatsSnapshot
+    StatsSnapshot GetStatsSnapshot() const;
+    // Region of interest: stats between the markers are also printed as a
+    // separate "phases" section per name. Beginning a region ends the open
+    // one, markers are recorded in the address trace (addr_trace = true).
+    void BeginROI(const std::string &name);
+    void EndROI();
+
+    // Save/restore the complete simulator state (queues, bank states,
+    // refresh counters and stats) so that one warmed up state can be
+    // reused by many runs with the same DRAM organization.
+    // Callbacks are not part of the state and have to be registered again
+    bool SaveCheckpoint(const std::string &file_name) const;
+    bool LoadCheckpoint(const std::string &file_name);
+
+    // Fast-forward (functional warm-up) mode: requests only update the
+    // open rows and the write buffer and complete on the next tick, cycles
+    // are only counted. Detailed simulation resumes after cycle_marker
+    // DRAM cycles or request_marker requests (0 means no marker), or
+    // when StopFastForward() is called.
+    void StartFastForward(uint64_t cycle_marker, uint64_t request_marker);
+    void StopFastForward();
+    bool IsFastForwarding() const;
 
     std::pair<uint64_t, int> ReturnDoneTrans(uint64_t clk); /////////// add for NMP core
     int GetPendingReadQueueCount();
@@ -34,6 +72,17 @@ class MemorySystem {
 
     bool WillAcceptTransaction(uint64_t hex_addr, bool is_write) const;
     bool AddTransaction(uint64_t hex_addr, bool is_write);
+    // the tag is recorded in the address trace (addr_trace = true) and is
+    // the source id the command schedulers see (see num_sources)
+    bool AddTransaction(uint64_t hex_addr, bool is_write, uint32_t tag);
+    // requests of size bytes are split into one column burst per
+    // request_size_bytes they touch and called back once all are done,
+    // smaller ones take a single (on DDR3/DDR4 chopped) burst
+    bool WillAcceptSizedTransaction(uint64_t hex_addr, bool is_write,
+                                    uint32_t size) const;
+    bool AddSizedTransaction(uint64_t hex_addr, bool is_write, uint32_t size);
+    bool AddSizedTransaction(uint64_t hex_addr, bool is_write, uint32_t size,
+                             uint32_t tag);
 
    private:
     // These have to be pointers because Gem5 will try to push this object
@@ -41,6 +90,20 @@ class MemorySystem {
     // here is safe
     Config *config_;
     BaseDRAMSystem *dram_system_;
+    // defaults to 1:1 until a host frequency is registered
+    ClockDomainCrosser host_clock_;
+    AddrTraceWriter *addr_trace_;
+
+    bool fast_forward_;
+    uint64_t ff_cycles_;
+    uint64_t ff_requests_;
+    uint64_t ff_cycle_marker_;
+    uint64_t ff_request_marker_;
+    // requests warmed but not yet returned to the host, addr and is_write
+    std::vector<std::pair<uint64_t, bool>> ff_returns_;
+    std::function<void(uint64_t)> read_callback_, write_callback_;
+    void ReturnWarmedRequests();
+    void FastForwardCycles(uint64_t dram_cycles);
 };
 
 MemorySystem* GetMemorySystem(const std::string &config_file, const std::string &output_dir,
@@ -0,0 +1,64 @@
+#include "profiler.h"
+
+#ifdef PROFILE
+#include "fmt/format.h"
+
+namespace dramsim3 {
+
+namespace {
+const char* kPhaseNames[] = {"refresh", "schedule_trans", "get_command",
+                             "update_states", "stats"};
+}  // namespace
+
+ProfileClock::ProfileClock()
+    : start_time_(std::chrono::steady_clock::now()), start_tsc_(ReadTSC()) {}
+
+void ProfileClock::Report(std::ostream& out,
+                          const std::vector<const PhaseProfile*>& channels,
+                          uint64_t cycles, uint64_t requests) const {
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start_time_)
+                         .count();
+    double total_ticks = static_cast<double>(ReadTSC() - start_tsc_);
+    if (seconds <= 0.0 || total_ticks <= 0.0) {
+        return;
+    }
+    out << "########## Simulator profile ##########" << std::endl;
+    out << fmt::format("{:<24}{:>14.3f}", "wall_time_s", seconds) << std::endl;
+    out << fmt::format("{:<24}{:>14.0f}", "cycles_per_second",
+                       cycles / seconds)
+        << std::endl;
+    out << fmt::format("{:<24}{:>14.0f}", "requests_per_second",
+                       requests / seconds)
+        << std::endl;
+    int num_phases = static_cast<int>(ProfilePhase::SIZE);
+    uint64_t phase_ticks = 0;
+    for (int p = 0; p < num_phases; p++) {
+        uint64_t ticks = 0, calls = 0;
+        for (const auto* channel : channels) {
+            ticks += channel->ticks[p];
+            calls += channel->calls[p];
+        }
+        phase_ticks += ticks;
+        out << fmt::format("{:<24}{:>13.2f}%{:>16} calls", kPhaseNames[p],
+                           100.0 * ticks / total_ticks, calls)
+            << std::endl;
+    }
+    // host side, callbacks, output...
+    out << fmt::format("{:<24}{:>13.2f}%", "other",
+                       100.0 * (total_ticks - phase_ticks) / total_ticks)
+        << std::endl;
+    // per channel shares show imbalance between channels
+    for (size_t c = 0; c < channels.size(); c++) {
+        uint64_t ticks = 0;
+        for (int p = 0; p < num_phases; p++) {
+            ticks += channels[c]->ticks[p];
+        }
+        out << fmt::format("{:<24}{:>13.2f}%", "channel_" + std::to_string(c),
+                           100.0 * ticks / total_ticks)
+            << std::endl;
+    }
+}
+
+}  // namespace dramsim3
+#endif  // PROFILE
@@ -0,0 +1,86 @@
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#include <stdint.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace dramsim3 {
+
+// Self-profiling of the simulator, only compiled in with -DPROFILE so that
+// regular builds do not pay for a single timestamp. Each controller keeps
+// its own PhaseProfile, the memory system prints the report at the end.
+#ifdef PROFILE
+
+enum class ProfilePhase {
+    REFRESH,
+    SCHEDULE_TRANS,
+    GET_COMMAND,
+    UPDATE_STATES,
+    STATS,
+    SIZE
+};
+
+inline uint64_t ReadTSC() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+struct PhaseProfile {
+    PhaseProfile() : ticks(), calls() {}
+    uint64_t ticks[static_cast<int>(ProfilePhase::SIZE)];
+    uint64_t calls[static_cast<int>(ProfilePhase::SIZE)];
+};
+
+class ScopedTimer {
+   public:
+    ScopedTimer(PhaseProfile& profile, ProfilePhase phase)
+        : profile_(profile), phase_(static_cast<int>(phase)), start_(ReadTSC()) {}
+    ~ScopedTimer() {
+        profile_.ticks[phase_] += ReadTSC() - start_;
+        profile_.calls[phase_]++;
+    }
+
+   private:
+    PhaseProfile& profile_;
+    int phase_;
+    uint64_t start_;
+};
+
+// wall clock and timestamp counter since construction, the ratio of the two
+// calibrates ticks to seconds
+class ProfileClock {
+   public:
+    ProfileClock();
+    void Report(std::ostream& out,
+                const std::vector<const PhaseProfile*>& channels,
+                uint64_t cycles, uint64_t requests) const;
+
+   private:
+    std::chrono::steady_clock::time_point start_time_;
+    uint64_t start_tsc_;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(profile, phase) \
+    ScopedTimer PROFILE_CONCAT(scoped_timer_, __LINE__)(profile, phase)
+
+#else
+
+#define PROFILE_SCOPE(profile, phase)
+
+#endif  // PROFILE
+
+}  // namespace dramsim3
+#endif
@@ -1,14 +1,25 @@
 #include "refresh.h"
+#include <algorithm>
+#include "checkpoint.h"
 
 namespace dramsim3 {
-Refresh::Refresh(const Config &config, ChannelState &channel_state)
+Refresh::Refresh(int channel_id, const Config &config,
+                 ChannelState &channel_state, const CommandQueue &cmd_queue,
+                 SimpleStats &simple_stats)
     : clk_(0),
       config_(config),
       channel_state_(channel_state),
+      cmd_queue_(cmd_queue),
+      simple_stats_(simple_stats),
       refresh_policy_(config.refresh_policy),
       next_rank_(0),
       next_bg_(0),
-      next_bank_(0) {
+      next_bank_(0),
+      debt_(config.ranks, 0),
+      flexible_(config.refresh_postpone > 0 || config.refresh_pullin > 0),
+      ref_slots_(config.ranks, 0),
+      num_groups_(1),
+      rows_per_group_(config.rows) {
     if (refresh_policy_ == RefreshPolicy::RANK_LEVEL_SIMULTANEOUS) {
         refresh_interval_ = config_.tREFI;
     } else if (refresh_policy_ == RefreshPolicy::BANK_LEVEL_STAGGERED) {
@@ -16,23 +27,94 @@ Refresh::Refresh(const Config &config, ChannelState &channel_state)
     } else {  // default refresh scheme: RANK STAGGERED
         refresh_interval_ = config_.tREFI / config_.ranks;
     }
+    if (config_.retention_aware) {
+        retention_.reset(new RetentionBins(config_, channel_id));
+        num_groups_ = std::max(
+            1, static_cast<int>(64 * 1e6 / (config_.tREFI * config_.tCK)));
+        rows_per_group_ = (config_.rows + num_groups_ - 1) / num_groups_;
+    }
 }
 
 void Refresh::ClockTick() {
     if (clk_ % refresh_interval_ == 0 && clk_ > 0) {
         InsertRefresh();
     }
+    if (flexible_) {
+        SettleDebt();
+    }
     clk_++;
     return;
 }
 
+void Refresh::FastForward(uint64_t cycles) {
+    // number of refresh slots in [clk_, clk_ + cycles), slot 0 never fires
+    uint64_t interval = static_cast<uint64_t>(refresh_interval_);
+    uint64_t end = clk_ + cycles;
+    uint64_t slots = (end + interval - 1) / interval -
+                     (clk_ + interval - 1) / interval;
+    if (clk_ == 0 && slots > 0) {
+        slots -= 1;
+    }
+    if (retention_) {
+        // the skipped slots still move the row groups along, except for
+        // ranks in self refresh, which stay so while fast forwarding and
+        // skip their slots just like InsertRefresh does
+        if (refresh_policy_ == RefreshPolicy::RANK_LEVEL_STAGGERED) {
+            uint64_t ranks = config_.ranks;
+            for (uint64_t r = 0; r < ranks; r++) {
+                if (channel_state_.IsRankSelfRefreshing(r)) {
+                    continue;
+                }
+                uint64_t offset = (r + ranks - next_rank_) % ranks;
+                ref_slots_[r] += slots / ranks + (offset < slots % ranks);
+            }
+        } else if (refresh_policy_ == RefreshPolicy::RANK_LEVEL_SIMULTANEOUS) {
+            for (int r = 0; r < config_.ranks; r++) {
+                if (!channel_state_.IsRankSelfRefreshing(r)) {
+                    ref_slots_[r] += slots;
+                    break;
+                }
+            }
+        }
+    }
+    if (refresh_policy_ != RefreshPolicy::RANK_LEVEL_SIMULTANEOUS) {
+        uint64_t period = config_.ranks;
+        if (refresh_policy_ == RefreshPolicy::BANK_LEVEL_STAGGERED) {
+            period *= config_.banks;
+        }
+        for (uint64_t i = 0; i < slots % period; i++) {
+            IterateNext();
+        }
+    }
+    clk_ = end;
+    return;
+}
+
+void Refresh::SaveState(CheckpointWriter &out) const {
+    out.Write(clk_);
+    out.Write(next_rank_);
+    out.Write(next_bg_);
+    out.Write(next_bank_);
+    out.Write(debt_);
+    out.Write(ref_slots_);
+}
+
+void Refresh::LoadState(CheckpointReader &in) {
+    in.Read(clk_);
+    in.Read(next_rank_);
+    in.Read(next_bg_);
+    in.Read(next_bank_);
+    in.Read(debt_);
+    in.Read(ref_slots_);
+}
+
 void Refresh::InsertRefresh() {
     switch (refresh_policy_) {
         // Simultaneous all rank refresh
         case RefreshPolicy::RANK_LEVEL_SIMULTANEOUS:
             for (auto i = 0; i < config_.ranks; i++) {
                 if (!channel_state_.IsRankSelfRefreshing(i)) {
-                    channel_state_.RankNeedRefresh(i, true);
+                    RankRefreshDue(i);
                     break;
                 }
             }
@@ -40,7 +122,7 @@ void Refresh::InsertRefresh() {
         // Staggered all rank refresh
         case RefreshPolicy::RANK_LEVEL_STAGGERED:
             if (!channel_state_.IsRankSelfRefreshing(next_rank_)) {
-                channel_state_.RankNeedRefresh(next_rank_, true);
+                RankRefreshDue(next_rank_);
             }
             IterateNext();
             break;
@@ -59,6 +141,67 @@ void Refresh::InsertRefresh() {
     return;
 }
 
+void Refresh::RankRefreshDue(int rank) {
+    if (retention_ && !RowGroupDue(rank)) {
+        simple_stats_.Increment("num_skipped_refs");
+        return;
+    }
+    debt_[rank]++;
+    if (debt_[rank] <= 0) {
+        // pulled in ahead of time
+        return;
+    }
+    // only demand queued for the rank defers a refresh
+    if (debt_[rank] > config_.refresh_postpone || cmd_queue_.RankEmpty(rank)) {
+        RequestRankRefresh(rank);
+    } else {
+        simple_stats_.Increment("num_postponed_refs");
+    }
+    return;
+}
+
+bool Refresh::RowGroupDue(int rank) {
+    uint64_t slot = ref_slots_[rank]++;
+    int first_row = static_cast<int>(slot % num_groups_) * rows_per_group_;
+    int last_row = std::min(first_row + rows_per_group_, config_.rows);
+    // the row group is due if its weakest row is, counted in 64ms windows
+    int multiple = 4;
+    for (int row = first_row; row < last_row && multiple > 1; row++) {
+        for (int bg = 0; bg < config_.bankgroups; bg++) {
+            for (int b = 0; b < config_.banks_per_group; b++) {
+                multiple = std::min(
+                    multiple, retention_->PeriodMultiple(rank, bg, b, row));
+            }
+        }
+    }
+    return (slot / num_groups_) % multiple == 0;
+}
+
+void Refresh::SettleDebt() {
+    // idle ranks pay back postponed refreshes first, then get ahead
+    for (int i = 0; i < config_.ranks; i++) {
+        if (channel_state_.IsRankSelfRefreshing(i) ||
+            channel_state_.IsRankRefreshWaiting(i) || !cmd_queue_.RankEmpty(i)) {
+            continue;
+        }
+        // pulling in is optional and not worth waking a powered-down rank
+        if (debt_[i] > 0 || (debt_[i] > -config_.refresh_pullin &&
+                             !channel_state_.IsRankPoweredDown(i))) {
+            RequestRankRefresh(i);
+            if (debt_[i] < 0) {
+                simple_stats_.Increment("num_pulledin_refs");
+            }
+        }
+    }
+    return;
+}
+
+void Refresh::RequestRankRefresh(int rank) {
+    channel_state_.RankNeedRefresh(rank, true);
+    debt_[rank]--;
+    return;
+}
+
 void Refresh::IterateNext() {
     switch (refresh_policy_) {
         case RefreshPolicy::RANK_LEVEL_STAGGERED:
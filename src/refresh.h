@@ -1,28 +1,58 @@
 #ifndef __REFRESH_H
 #define __REFRESH_H
 
+#include <memory>
 #include <vector>
 #include "channel_state.h"
+#include "command_queue.h"
 #include "common.h"
 #include "configuration.h"
+#include "retention.h"
+#include "simple_stats.h"
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 class Refresh {
    public:
-    Refresh(const Config& config, ChannelState& channel_state);
+    Refresh(int channel_id, const Config& config, ChannelState& channel_state,
+            const CommandQueue& cmd_queue, SimpleStats& simple_stats);
     void ClockTick();
+    // skip cycles without issuing refreshes, only the rotation is kept
+    // so that the refresh phase is realistic afterwards
+    void FastForward(uint64_t cycles);
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
 
    private:
     uint64_t clk_;
     int refresh_interval_;
     const Config& config_;
     ChannelState& channel_state_;
+    const CommandQueue& cmd_queue_;
+    SimpleStats& simple_stats_;
     RefreshPolicy refresh_policy_;
 
     int next_rank_, next_bg_, next_bank_;
 
+    // refreshes owed per rank, negative when pulled in ahead of time
+    std::vector<int> debt_;
+    bool flexible_;
+
+    // retention aware refresh: refresh slots per rank so far, each covers
+    // the next rows_per_group_ rows of every bank, num_groups_ per 64ms
+    std::unique_ptr<RetentionBins> retention_;
+    std::vector<uint64_t> ref_slots_;
+    int num_groups_;
+    int rows_per_group_;
+    bool RowGroupDue(int rank);
+
     void InsertRefresh();
+    void RankRefreshDue(int rank);
+    void SettleDebt();
+    void RequestRankRefresh(int rank);
 
     void IterateNext();
 };
@@ -0,0 +1,134 @@
+#include "retention.h"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "common.h"
+
+namespace dramsim3 {
+
+namespace {
+// splitmix64
+uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// hash functions per bin as in the RAIDR paper
+const int kHashes64ms = 10;
+const int kHashes128ms = 6;
+}  // namespace
+
+BloomFilter::BloomFilter(int num_bits, int num_hashes)
+    : num_hashes_(num_hashes), bits_(num_bits, false) {}
+
+uint64_t BloomFilter::Index(uint64_t key, int i) const {
+    // double hashing, the second hash is odd so every bit can be reached
+    uint64_t h1 = Mix(key);
+    uint64_t h2 = Mix(h1) | 1;
+    return (h1 + i * h2) % bits_.size();
+}
+
+void BloomFilter::Insert(uint64_t key) {
+    for (int i = 0; i < num_hashes_; i++) {
+        bits_[Index(key, i)] = true;
+    }
+}
+
+bool BloomFilter::MayContain(uint64_t key) const {
+    for (int i = 0; i < num_hashes_; i++) {
+        if (!bits_[Index(key, i)]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+RetentionBins::RetentionBins(const Config& config, int channel)
+    : config_(config),
+      bin_64ms_(config.retention_bloom_bits_64ms, kHashes64ms),
+      bin_128ms_(config.retention_bloom_bits_128ms, kHashes128ms) {
+    if (config_.retention_profile.empty()) {
+        Synthesize(channel);
+    } else {
+        LoadProfile(channel);
+    }
+}
+
+int RetentionBins::PeriodMultiple(int rank, int bankgroup, int bank,
+                                  int row) const {
+    uint64_t key = RowKey(rank, bankgroup, bank, row);
+    if (bin_64ms_.MayContain(key)) {
+        return 1;
+    } else if (bin_128ms_.MayContain(key)) {
+        return 2;
+    }
+    return 4;
+}
+
+uint64_t RetentionBins::RowKey(int rank, int bankgroup, int bank,
+                               int row) const {
+    uint64_t bank_idx =
+        (rank * config_.bankgroups + bankgroup) * config_.banks_per_group +
+        bank;
+    return bank_idx * config_.rows + row;
+}
+
+void RetentionBins::Add(int rank, int bankgroup, int bank, int row,
+                        double retention_ms) {
+    if (retention_ms < 128) {
+        bin_64ms_.Insert(RowKey(rank, bankgroup, bank, row));
+    } else if (retention_ms < 256) {
+        bin_128ms_.Insert(RowKey(rank, bankgroup, bank, row));
+    }
+}
+
+void RetentionBins::LoadProfile(int channel) {
+    // one row per line: channel rank bankgroup bank row retention_ms
+    std::ifstream in(config_.retention_profile);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open retention profile "
+                  << config_.retention_profile << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        int ch, rank, bankgroup, bank, row;
+        double retention_ms;
+        if (!(fields >> ch >> rank >> bankgroup >> bank >> row >>
+              retention_ms)) {
+            std::cerr << "Bad retention profile line: " << line << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        if (ch == channel) {
+            Add(rank, bankgroup, bank, row, retention_ms);
+        }
+    }
+}
+
+void RetentionBins::Synthesize(int channel) {
+    std::mt19937_64 gen(config_.retention_seed + channel);
+    std::uniform_int_distribution<int> rank_dist(0, config_.ranks - 1);
+    std::uniform_int_distribution<int> bg_dist(0, config_.bankgroups - 1);
+    std::uniform_int_distribution<int> bank_dist(0,
+                                                 config_.banks_per_group - 1);
+    std::uniform_int_distribution<int> row_dist(0, config_.rows - 1);
+    double rows = static_cast<double>(config_.ranks) * config_.banks *
+                  config_.rows;
+    int num_64ms = static_cast<int>(rows * config_.retention_rate_64ms + 0.5);
+    int num_128ms =
+        static_cast<int>(rows * config_.retention_rate_128ms + 0.5);
+    for (int i = 0; i < num_64ms + num_128ms; i++) {
+        Add(rank_dist(gen), bg_dist(gen), bank_dist(gen), row_dist(gen),
+            i < num_64ms ? 64 : 128);
+    }
+}
+
+}  // namespace dramsim3
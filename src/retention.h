@@ -0,0 +1,47 @@
+#ifndef __RETENTION_H
+#define __RETENTION_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// Bloom filter, a key that was inserted is always reported, others are
+// reported with a small false positive rate
+class BloomFilter {
+   public:
+    BloomFilter(int num_bits, int num_hashes);
+    void Insert(uint64_t key);
+    bool MayContain(uint64_t key) const;
+
+   private:
+    int num_hashes_;
+    std::vector<bool> bits_;
+    uint64_t Index(uint64_t key, int i) const;
+};
+
+// RAIDR style retention bins of the rows of one channel. Rows that keep
+// their data for less than 128ms are refreshed every 64ms, rows below 256ms
+// every 128ms and all others every 256ms. A false positive only refreshes a
+// row more often than needed. The bins come from retention_profile or,
+// without one, from a synthetic distribution of weak rows.
+class RetentionBins {
+   public:
+    RetentionBins(const Config& config, int channel);
+    // refresh period of a row in multiples of 64ms: 1, 2 or 4
+    int PeriodMultiple(int rank, int bankgroup, int bank, int row) const;
+
+   private:
+    const Config& config_;
+    BloomFilter bin_64ms_;
+    BloomFilter bin_128ms_;
+    uint64_t RowKey(int rank, int bankgroup, int bank, int row) const;
+    void Add(int rank, int bankgroup, int bank, int row, double retention_ms);
+    void LoadProfile(int channel);
+    void Synthesize(int channel);
+};
+
+}  // namespace dramsim3
+#endif
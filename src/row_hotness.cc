@@ -0,0 +1,168 @@
+#include "row_hotness.h"
+
+#include <algorithm>
+
+#include "checkpoint.h"
+
+namespace dramsim3 {
+
+namespace {
+// splitmix64, good enough to derive independent hash seeds
+uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+}  // namespace
+
+CountMinSketch::CountMinSketch(int width, int depth)
+    : width_(width), depth_(depth), counters_(width * depth, 0) {
+    for (int d = 0; d < depth_; d++) {
+        seeds_.push_back(Mix(d + 1));
+    }
+}
+
+int CountMinSketch::Index(int d, uint64_t key) const {
+    return d * width_ + static_cast<int>(Mix(key ^ seeds_[d]) % width_);
+}
+
+uint32_t CountMinSketch::Add(uint64_t key) {
+    uint32_t estimate = UINT32_MAX;
+    for (int d = 0; d < depth_; d++) {
+        auto& counter = counters_[Index(d, key)];
+        if (counter < UINT32_MAX) {
+            counter++;
+        }
+        estimate = std::min(estimate, counter);
+    }
+    return estimate;
+}
+
+uint32_t CountMinSketch::Estimate(uint64_t key) const {
+    uint32_t estimate = UINT32_MAX;
+    for (int d = 0; d < depth_; d++) {
+        estimate = std::min(estimate, counters_[Index(d, key)]);
+    }
+    return depth_ > 0 ? estimate : 0;
+}
+
+void CountMinSketch::Clear() {
+    std::fill(counters_.begin(), counters_.end(), 0);
+}
+
+void CountMinSketch::SaveState(CheckpointWriter& out) const {
+    out.Write(counters_);
+}
+
+void CountMinSketch::LoadState(CheckpointReader& in) {
+    size_t size = counters_.size();
+    in.Read(counters_);
+    if (counters_.size() != size) {
+        std::cerr << "Checkpoint was taken with a different sketch size!"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+}
+
+// nothing is allocated unless tracking is enabled
+RowHotness::RowHotness(const Config& config)
+    : config_(config),
+      epoch_(config.row_hotness ? config.cms_width : 0,
+             config.row_hotness ? config.cms_depth : 0),
+      total_(config.row_hotness ? config.cms_width : 0,
+             config.row_hotness ? config.cms_depth : 0) {}
+
+uint64_t RowHotness::RowKey(const Address& addr) const {
+    uint64_t bank = (addr.rank * config_.bankgroups + addr.bankgroup) *
+                        config_.banks_per_group +
+                    addr.bank;
+    return bank * config_.rows + addr.row;
+}
+
+void RowHotness::Activate(const Address& addr) {
+    uint64_t key = RowKey(addr);
+    Add(epoch_, key);
+    Add(total_, key);
+}
+
+void RowHotness::Add(Tracker& tracker, uint64_t key) {
+    uint32_t count = tracker.sketch.Add(key);
+    auto& top = tracker.top;
+    auto it = std::find_if(top.begin(), top.end(),
+                           [key](const HotRow& r) { return r.key == key; });
+    if (it != top.end()) {
+        it->count = count;
+    } else if (static_cast<int>(top.size()) < config_.hot_rows_topk) {
+        top.push_back({key, count});
+    } else {
+        // K is small, a linear scan is cheaper than keeping a heap in sync
+        auto min_it = std::min_element(
+            top.begin(), top.end(),
+            [](const HotRow& a, const HotRow& b) { return a.count < b.count; });
+        if (count > min_it->count) {
+            *min_it = {key, count};
+        }
+    }
+}
+
+uint32_t RowHotness::Estimate(const Address& addr) const {
+    return total_.sketch.Estimate(RowKey(addr));
+}
+
+uint32_t RowHotness::EpochEstimate(const Address& addr) const {
+    return epoch_.sketch.Estimate(RowKey(addr));
+}
+
+nlohmann::json RowHotness::ToJson(const std::vector<HotRow>& top) const {
+    auto sorted = top;
+    std::sort(sorted.begin(), sorted.end(),
+              [](const HotRow& a, const HotRow& b) { return a.count > b.count; });
+    nlohmann::json j_list = nlohmann::json::array();
+    for (const auto& r : sorted) {
+        uint64_t bank = r.key / config_.rows;
+        nlohmann::json j_row;
+        j_row["rank"] = bank / config_.banks;
+        j_row["bankgroup"] = bank % config_.banks / config_.banks_per_group;
+        j_row["bank"] = bank % config_.banks_per_group;
+        j_row["row"] = r.key % config_.rows;
+        j_row["activations"] = r.count;
+        j_list.push_back(j_row);
+    }
+    return j_list;
+}
+
+nlohmann::json RowHotness::EpochHotRows() const { return ToJson(epoch_.top); }
+
+nlohmann::json RowHotness::HotRows() const { return ToJson(total_.top); }
+
+void RowHotness::ClearEpoch() {
+    epoch_.sketch.Clear();
+    epoch_.top.clear();
+}
+
+void RowHotness::SaveState(CheckpointWriter& out) const {
+    for (const auto* tracker : {&epoch_, &total_}) {
+        tracker->sketch.SaveState(out);
+        out.Write(static_cast<uint64_t>(tracker->top.size()));
+        for (const auto& r : tracker->top) {
+            out.Write(r.key);
+            out.Write(r.count);
+        }
+    }
+}
+
+void RowHotness::LoadState(CheckpointReader& in) {
+    for (auto* tracker : {&epoch_, &total_}) {
+        tracker->sketch.LoadState(in);
+        uint64_t size;
+        in.Read(size);
+        tracker->top.resize(size);
+        for (auto& r : tracker->top) {
+            in.Read(r.key);
+            in.Read(r.count);
+        }
+    }
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,76 @@
+#ifndef __ROW_HOTNESS_H
+#define __ROW_HOTNESS_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "common.h"
+#include "configuration.h"
+#include "json.hpp"
+
+namespace dramsim3 {
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Count-min sketch, estimates never undercount and overcount by at most
+// 2 * total / width with probability 1 - (1/2)^depth
+class CountMinSketch {
+   public:
+    CountMinSketch(int width, int depth);
+    // returns the estimate after adding
+    uint32_t Add(uint64_t key);
+    uint32_t Estimate(uint64_t key) const;
+    void Clear();
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
+   private:
+    int width_;
+    int depth_;
+    std::vector<uint64_t> seeds_;
+    std::vector<uint32_t> counters_;  // depth_ rows of width_ counters
+    int Index(int d, uint64_t key) const;
+};
+
+// Per channel activation hotness with a fixed memory footprint: a sketch
+// answers per-row queries and the K rows with the largest estimates are
+// kept as heavy hitters. One tracker covers the current epoch and one the
+// whole simulation.
+class RowHotness {
+   public:
+    explicit RowHotness(const Config& config);
+    void Activate(const Address& addr);
+    // estimated activations of a row, so far and in the current epoch
+    uint32_t Estimate(const Address& addr) const;
+    uint32_t EpochEstimate(const Address& addr) const;
+    // hottest rows, hottest first
+    nlohmann::json EpochHotRows() const;
+    nlohmann::json HotRows() const;
+    void ClearEpoch();
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
+   private:
+    struct HotRow {
+        uint64_t key;
+        uint32_t count;
+    };
+
+    struct Tracker {
+        Tracker(int width, int depth) : sketch(width, depth) {}
+        CountMinSketch sketch;
+        std::vector<HotRow> top;
+    };
+
+    const Config& config_;
+    Tracker epoch_;
+    Tracker total_;
+
+    uint64_t RowKey(const Address& addr) const;
+    void Add(Tracker& tracker, uint64_t key);
+    nlohmann::json ToJson(const std::vector<HotRow>& top) const;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,43 @@
+#include "row_predictor.h"
+
+#include "checkpoint.h"
+
+namespace dramsim3 {
+
+RowPredictor::RowPredictor(int num_banks, int counter_bits)
+    : max_count_((1 << counter_bits) - 1),
+      counters_(num_banks, (max_count_ + 1) / 2),
+      last_rows_(num_banks, -1) {}
+
+bool RowPredictor::KeepOpen(int bank) const {
+    return counters_[bank] > max_count_ / 2;
+}
+
+bool RowPredictor::Update(int bank, int row) {
+    int last_row = last_rows_[bank];
+    last_rows_[bank] = row;
+    if (last_row < 0) {
+        return true;
+    }
+    bool predicted_hit = KeepOpen(bank);
+    bool hit = row == last_row;
+    int& counter = counters_[bank];
+    if (hit && counter < max_count_) {
+        counter++;
+    } else if (!hit && counter > 0) {
+        counter--;
+    }
+    return predicted_hit == hit;
+}
+
+void RowPredictor::SaveState(CheckpointWriter& out) const {
+    out.Write(counters_);
+    out.Write(last_rows_);
+}
+
+void RowPredictor::LoadState(CheckpointReader& in) {
+    in.Read(counters_);
+    in.Read(last_rows_);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,31 @@
+#ifndef __ROW_PREDICTOR_H
+#define __ROW_PREDICTOR_H
+
+#include <vector>
+
+namespace dramsim3 {
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// Per bank saturating counters that predict whether the next access to a
+// bank hits the row of the current one. Counters in the upper half keep the
+// row open, the lower half auto-precharges.
+class RowPredictor {
+   public:
+    RowPredictor(int num_banks, int counter_bits);
+    bool KeepOpen(int bank) const;
+    // an access to row of bank was scheduled, returns whether the
+    // prediction for the previous access to the bank was right
+    bool Update(int bank, int row);
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
+   private:
+    int max_count_;
+    std::vector<int> counters_;
+    std::vector<int> last_rows_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,203 @@
+#include "sampling.h"
+
+#include <cmath>
+#include <iostream>
+#include "fmt/format.h"
+#include "json.hpp"
+
+namespace dramsim3 {
+
+namespace {
+// two-sided 95% Student t quantiles for 1 to 30 degrees of freedom,
+// the normal quantile is close enough beyond that
+const double kTQuantiles[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447,
+                              2.365,  2.306, 2.262, 2.228, 2.201, 2.179,
+                              2.160,  2.145, 2.131, 2.120, 2.110, 2.101,
+                              2.093,  2.086, 2.080, 2.074, 2.069, 2.064,
+                              2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+
+double TQuantile(int degrees_of_freedom) {
+    if (degrees_of_freedom <= 30) {
+        return kTQuantiles[degrees_of_freedom - 1];
+    }
+    return 1.96;
+}
+}  // namespace
+
+void SampleEstimate::AddSample(double value) {
+    // Welford's update, numerically stable for long runs
+    count_++;
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (value - mean_);
+}
+
+double SampleEstimate::HalfWidth() const {
+    if (count_ < 2) {
+        return 0.0;
+    }
+    double std_dev = std::sqrt(m2_ / (count_ - 1));
+    return TQuantile(count_ - 1) * std_dev / std::sqrt(count_);
+}
+
+double SampleEstimate::RelativeError() const {
+    double half_width = HalfWidth();
+    if (half_width == 0.0) {
+        return 0.0;
+    }
+    return half_width / std::fabs(mean_);
+}
+
+const std::vector<std::string> SampledTraceCPU::kMetricNames = {
+    "bandwidth", "row_hit_rate", "average_read_latency", "p99_read_latency",
+    "average_power"};
+
+SampledTraceCPU::SampledTraceCPU(const std::string& config_file,
+                                 const std::string& output_dir,
+                                 const std::string& trace_file,
+                                 const SamplingParams& params)
+    : CPU(config_file, output_dir),
+      trace_file_(trace_file),
+      output_dir_(output_dir),
+      params_(params),
+      estimates_(kMetricNames.size()) {
+    if (!trace_file_.IsOpen()) {
+        std::cerr << "Trace file does not exist" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    if (params_.window == 0 ||
+        params_.period < params_.warmup + params_.window) {
+        std::cerr << "Sample period must cover warm-up and window!"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+}
+
+void SampledTraceCPU::ClockTick() {
+    memory_system_.Tick();
+    clk_++;
+}
+
+bool SampledTraceCPU::NextTransaction() {
+    if (!has_trans_) {
+        has_trans_ = trace_file_.Next(trans_);
+    }
+    return has_trans_;
+}
+
+bool SampledTraceCPU::FastForward(uint64_t num_requests) {
+    if (num_requests == 0) {
+        return true;
+    }
+    memory_system_.StartFastForward(0, num_requests);
+    while (memory_system_.IsFastForwarding()) {
+        if (!NextTransaction()) {
+            memory_system_.StopFastForward();
+            return false;
+        }
+        // skipped cycles are only counted, this is cheap
+        if (trans_.added_cycle > clk_) {
+            memory_system_.AdvanceHostCycles(trans_.added_cycle - clk_);
+            clk_ = trans_.added_cycle;
+        }
+        memory_system_.AddTransaction(trans_.addr, trans_.is_write);
+        has_trans_ = false;
+        num_requests_++;
+        num_outstanding_++;
+    }
+    return true;
+}
+
+bool SampledTraceCPU::IssueDetailed(uint64_t num_requests) {
+    for (uint64_t i = 0; i < num_requests; i++) {
+        if (!NextTransaction()) {
+            return false;
+        }
+        while (trans_.added_cycle > clk_ ||
+               !memory_system_.WillAcceptTransaction(trans_.addr,
+                                                     trans_.is_write)) {
+            ClockTick();
+        }
+        memory_system_.AddTransaction(trans_.addr, trans_.is_write);
+        has_trans_ = false;
+        num_requests_++;
+        num_detailed_requests_++;
+        num_outstanding_++;
+    }
+    return true;
+}
+
+void SampledTraceCPU::Drain() {
+    while (num_outstanding_ > 0) {
+        ClockTick();
+    }
+}
+
+void SampledTraceCPU::AddSample(const StatsSnapshot& window) {
+    std::vector<double> values = {
+        window.Bandwidth(), window.RowHitRate(), window.AverageReadLatency(),
+        window.ReadLatencyPercentile(99.0), window.AveragePower()};
+    for (size_t i = 0; i < values.size(); i++) {
+        estimates_[i].AddSample(values[i]);
+    }
+}
+
+bool SampledTraceCPU::Converged() const {
+    if (params_.target_error <= 0.0 ||
+        estimates_[0].Count() < params_.min_samples) {
+        return false;
+    }
+    for (const auto& estimate : estimates_) {
+        if (estimate.RelativeError() > params_.target_error) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SampledTraceCPU::Run() {
+    uint64_t ff_requests = params_.period - params_.warmup - params_.window;
+    while (true) {
+        if (!FastForward(ff_requests) || !IssueDetailed(params_.warmup)) {
+            break;
+        }
+        StatsSnapshot start = memory_system_.GetStatsSnapshot();
+        if (!IssueDetailed(params_.window)) {
+            break;
+        }
+        // the window ends once its last requests are served
+        Drain();
+        AddSample(memory_system_.GetStatsSnapshot().Since(start));
+        if (Converged()) {
+            break;
+        }
+    }
+}
+
+void SampledTraceCPU::PrintStats() {
+    memory_system_.PrintStats();
+
+    nlohmann::json j_data;
+    j_data["num_samples"] = estimates_[0].Count();
+    j_data["num_requests"] = num_requests_;
+    j_data["num_detailed_requests"] = num_detailed_requests_;
+    j_data["converged"] = Converged();
+    std::cout << fmt::format("Sampled {} windows over {} requests ({} detailed)",
+                             estimates_[0].Count(), num_requests_,
+                             num_detailed_requests_)
+              << std::endl;
+    for (size_t i = 0; i < kMetricNames.size(); i++) {
+        const auto& estimate = estimates_[i];
+        j_data[kMetricNames[i]] = {{"mean", estimate.Mean()},
+                                   {"ci95", estimate.HalfWidth()},
+                                   {"rel_error", estimate.RelativeError()}};
+        std::cout << fmt::format("{:<30}{:^3}{:>12.4f} +/- {:.4f}",
+                                 kMetricNames[i], " = ", estimate.Mean(),
+                                 estimate.HalfWidth())
+                  << std::endl;
+    }
+    std::ofstream j_out(output_dir_ + "/sampling.json", std::ofstream::out);
+    j_out << j_data;
+}
+
+}  // namespace dramsim3
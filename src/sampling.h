@@ -0,0 +1,82 @@
+#ifndef DRAMSIM3_SAMPLING_H
+#define DRAMSIM3_SAMPLING_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "cpu.h"
+#include "simple_stats.h"
+
+namespace dramsim3 {
+
+// SMARTS-style sampling, all lengths are in requests: out of every period
+// requests the first ones are only functionally warmed (fast-forwarded),
+// the next warmup requests are simulated in detail but not measured and
+// the last window requests are measured
+struct SamplingParams {
+    uint64_t period;
+    uint64_t window;
+    uint64_t warmup;
+    // stop once the 95% confidence interval of every metric is within
+    // this relative error, 0 runs the whole trace
+    double target_error;
+    int min_samples;
+};
+
+// running mean and confidence interval of one metric over all samples
+class SampleEstimate {
+   public:
+    SampleEstimate() : count_(0), mean_(0.0), m2_(0.0) {}
+    void AddSample(double value);
+    int Count() const { return count_; }
+    double Mean() const { return mean_; }
+    double HalfWidth() const;
+    double RelativeError() const;
+
+   private:
+    int count_;
+    double mean_;
+    double m2_;
+};
+
+class SampledTraceCPU : public CPU {
+   public:
+    SampledTraceCPU(const std::string& config_file,
+                    const std::string& output_dir,
+                    const std::string& trace_file,
+                    const SamplingParams& params);
+    // a single detailed host cycle, trace cycles are host cycles too
+    void ClockTick() override;
+    // sample over the whole trace or until the error bound is reached
+    void Run();
+    void PrintStats() override;
+
+   private:
+    AddrTraceReader trace_file_;
+    std::string output_dir_;
+    SamplingParams params_;
+    Transaction trans_;
+    bool has_trans_ = false;
+    uint64_t num_requests_ = 0;
+    uint64_t num_detailed_requests_ = 0;
+    // requests issued but not called back yet
+    uint64_t num_outstanding_ = 0;
+
+    static const std::vector<std::string> kMetricNames;
+    std::vector<SampleEstimate> estimates_;
+
+    bool NextTransaction();
+    // returns false if the trace ended first
+    bool FastForward(uint64_t num_requests);
+    bool IssueDetailed(uint64_t num_requests);
+    // tick until every issued request has returned
+    void Drain();
+    void ReadCallBack(uint64_t addr) override { num_outstanding_--; }
+    void WriteCallBack(uint64_t addr) override { num_outstanding_--; }
+    void AddSample(const StatsSnapshot& window);
+    bool Converged() const;
+};
+
+}  // namespace dramsim3
+
+#endif  // DRAMSIM3_SAMPLING_H
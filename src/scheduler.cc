@@ -0,0 +1,251 @@
+#include "scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "checkpoint.h"
+
+namespace dramsim3 {
+
+namespace {
+bool SameBank(const Command& a, const Command& b) {
+    return a.Rank() == b.Rank() && a.Bankgroup() == b.Bankgroup() &&
+           a.Bank() == b.Bank();
+}
+
+// sources in order of their key, lowest first
+std::vector<int> RankSources(const std::vector<double>& keys) {
+    std::vector<int> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&keys](int a, int b) { return keys[a] < keys[b]; });
+    std::vector<int> rank(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        rank[order[i]] = i;
+    }
+    return rank;
+}
+}  // namespace
+
+bool FCFSScheduler::IsEligible(const CMDQueue& queue, size_t pos) const {
+    for (size_t i = 0; i < pos; i++) {
+        if (SameBank(queue[i], queue[pos])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+BLISSScheduler::BLISSScheduler(const Config& config)
+    : Scheduler(config),
+      blacklisted_(config.num_sources, false),
+      last_source_(-1),
+      streak_(0) {}
+
+uint64_t BLISSScheduler::Priority(const Command& queued,
+                                  const Command& ready) const {
+    uint64_t priority = blacklisted_[queued.source] ? 0 : 2;
+    return priority + (ready.IsReadWrite() ? 1 : 0);
+}
+
+void BLISSScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    if (!cmd.IsReadWrite()) {
+        return;
+    }
+    int source = cmd.source;
+    if (source == last_source_) {
+        streak_++;
+    } else {
+        last_source_ = source;
+        streak_ = 1;
+    }
+    if (streak_ >= config_.bliss_threshold) {
+        blacklisted_[source] = true;
+    }
+}
+
+void BLISSScheduler::ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) {
+    if (clk % config_.bliss_clear_interval == 0) {
+        std::fill(blacklisted_.begin(), blacklisted_.end(), false);
+    }
+}
+
+void BLISSScheduler::SaveState(CheckpointWriter& out) const {
+    out.Write(blacklisted_);
+    out.Write(last_source_);
+    out.Write(streak_);
+}
+
+void BLISSScheduler::LoadState(CheckpointReader& in) {
+    in.Read(blacklisted_);
+    in.Read(last_source_);
+    in.Read(streak_);
+}
+
+PARBSScheduler::PARBSScheduler(const Config& config)
+    : Scheduler(config), num_marked_(0), source_rank_(config.num_sources, 0) {}
+
+uint64_t PARBSScheduler::Priority(const Command& queued,
+                                  const Command& ready) const {
+    // marked, then row hit, then source rank
+    uint64_t num_ranks = config_.num_sources;
+    uint64_t marked = queued.marked ? 1 : 0;
+    uint64_t hit = ready.IsReadWrite() ? 1 : 0;
+    return (marked * 2 + hit) * num_ranks +
+           (num_ranks - 1 - source_rank_[queued.source]);
+}
+
+uint64_t PARBSScheduler::MaxPriority() const {
+    return 4 * config_.num_sources - 1;
+}
+
+void PARBSScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    if (cmd.IsReadWrite() && cmd.marked) {
+        num_marked_--;
+    }
+}
+
+void PARBSScheduler::ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) {
+    if (num_marked_ > 0) {
+        return;
+    }
+    // idle cycles have nothing to mark and keep the last ranking
+    for (const auto& queue : queues) {
+        if (!queue.empty()) {
+            FormBatch(queues);
+            return;
+        }
+    }
+}
+
+void PARBSScheduler::FormBatch(std::vector<CMDQueue>& queues) {
+    int num_banks = config_.ranks * config_.banks;
+    // marked commands per source and bank
+    std::vector<std::vector<int> > load(config_.num_sources,
+                                        std::vector<int>(num_banks, 0));
+    for (auto& queue : queues) {
+        for (auto& cmd : queue) {
+            int bank = (cmd.Rank() * config_.bankgroups + cmd.Bankgroup()) *
+                           config_.banks_per_group +
+                       cmd.Bank();
+            auto& count = load[cmd.source][bank];
+            if (count < config_.parbs_batch_cap) {
+                count++;
+                cmd.marked = true;
+                num_marked_++;
+            }
+        }
+    }
+    // shortest job first: lowest max per bank load, then lowest total load
+    std::vector<double> keys(config_.num_sources);
+    for (int s = 0; s < config_.num_sources; s++) {
+        int max_load = *std::max_element(load[s].begin(), load[s].end());
+        int total = std::accumulate(load[s].begin(), load[s].end(), 0);
+        keys[s] = static_cast<double>(max_load) * (num_banks *
+                                                   config_.parbs_batch_cap +
+                                                   1) +
+                  total;
+    }
+    source_rank_ = RankSources(keys);
+}
+
+void PARBSScheduler::SaveState(CheckpointWriter& out) const {
+    out.Write(num_marked_);
+    out.Write(source_rank_);
+}
+
+void PARBSScheduler::LoadState(CheckpointReader& in) {
+    in.Read(num_marked_);
+    in.Read(source_rank_);
+}
+
+ATLASScheduler::ATLASScheduler(const Config& config)
+    : Scheduler(config),
+      clk_(0),
+      quantum_service_(config.num_sources, 0.0),
+      total_service_(config.num_sources, 0.0),
+      source_rank_(config.num_sources, 0) {}
+
+uint64_t ATLASScheduler::Priority(const Command& queued,
+                                  const Command& ready) const {
+    // starving, then least attained service, then row hit
+    uint64_t num_ranks = config_.num_sources;
+    uint64_t starved =
+        clk_ - queued.added_cycle >
+                static_cast<uint64_t>(config_.atlas_starvation)
+            ? 1
+            : 0;
+    uint64_t rank = num_ranks - 1 - source_rank_[queued.source];
+    uint64_t hit = ready.IsReadWrite() ? 1 : 0;
+    return (starved * num_ranks + rank) * 2 + hit;
+}
+
+uint64_t ATLASScheduler::MaxPriority() const {
+    return (2 * config_.num_sources - 1) * 2 + 1;
+}
+
+void ATLASScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    // bank time spent on the source
+    int service = 0;
+    if (cmd.IsReadWrite()) {
+        service = config_.burst_cycle;
+    } else if (cmd.cmd_type == CommandType::ACTIVATE) {
+        service = config_.tRCD;
+    } else if (cmd.cmd_type == CommandType::PRECHARGE) {
+        service = config_.tRP;
+    }
+    quantum_service_[cmd.source] += service;
+}
+
+void ATLASScheduler::ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) {
+    clk_ = clk;
+    if (clk % config_.atlas_quantum == 0) {
+        for (int s = 0; s < config_.num_sources; s++) {
+            total_service_[s] = config_.atlas_alpha * total_service_[s] +
+                                (1.0 - config_.atlas_alpha) *
+                                    quantum_service_[s];
+            quantum_service_[s] = 0.0;
+        }
+        UpdateRanks();
+    }
+}
+
+void ATLASScheduler::UpdateRanks() {
+    source_rank_ = RankSources(total_service_);
+}
+
+void ATLASScheduler::SaveState(CheckpointWriter& out) const {
+    out.Write(clk_);
+    out.Write(quantum_service_);
+    out.Write(total_service_);
+    out.Write(source_rank_);
+}
+
+void ATLASScheduler::LoadState(CheckpointReader& in) {
+    in.Read(clk_);
+    in.Read(quantum_service_);
+    in.Read(total_service_);
+    in.Read(source_rank_);
+}
+
+std::unique_ptr<Scheduler> MakeScheduler(const Config& config) {
+    std::unique_ptr<Scheduler> scheduler;
+    if (config.scheduler == "FCFS") {
+        scheduler.reset(new FCFSScheduler(config));
+    } else if (config.scheduler == "FRFCFS") {
+        scheduler.reset(new FRFCFSScheduler(config));
+    } else if (config.scheduler == "BLISS") {
+        scheduler.reset(new BLISSScheduler(config));
+    } else if (config.scheduler == "PARBS") {
+        scheduler.reset(new PARBSScheduler(config));
+    } else if (config.scheduler == "ATLAS") {
+        scheduler.reset(new ATLASScheduler(config));
+    } else {
+        std::cerr << "Unsupported scheduler " << config.scheduler
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    return scheduler;
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,130 @@
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <memory>
+#include <vector>
+#include "channel_state.h"
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+class CheckpointWriter;
+class CheckpointReader;
+
+using CMDQueue = std::vector<Command>;
+
+// Decides which ready command of a command queue goes first. Commands sit
+// in a queue in arrival order, the command queue walks it and keeps the
+// ready command with the highest priority, ties go to the older one.
+class Scheduler {
+   public:
+    explicit Scheduler(const Config& config) : config_(config) {}
+    virtual ~Scheduler() {}
+
+    // whether a queued command may be considered at all, FCFS only lets the
+    // oldest command of each bank through
+    virtual bool IsEligible(const CMDQueue& queue, size_t pos) const {
+        return true;
+    }
+    // whether a precharge should wait for pending hits to the open row
+    virtual bool HoldPrecharge(int row_hit_count) const {
+        return config_.row_hit_cap <= 0 || row_hit_count < config_.row_hit_cap;
+    }
+    // ready is the command the bank can take now on behalf of queued
+    virtual uint64_t Priority(const Command& queued,
+                              const Command& ready) const {
+        return 0;
+    }
+    // no command can beat this one, stop looking
+    virtual uint64_t MaxPriority() const { return 0; }
+
+    virtual void CommandIssued(const Command& cmd, uint64_t clk) {}
+    virtual void ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) {}
+    virtual void SaveState(CheckpointWriter& out) const {}
+    virtual void LoadState(CheckpointReader& in) {}
+
+   protected:
+    const Config& config_;
+};
+
+class FCFSScheduler : public Scheduler {
+   public:
+    using Scheduler::Scheduler;
+    bool IsEligible(const CMDQueue& queue, size_t pos) const override;
+    bool HoldPrecharge(int row_hit_count) const override { return false; }
+};
+
+// first ready in queue order, row hits are served first because a miss
+// cannot precharge while hits are pending (up to row_hit_cap of them)
+class FRFCFSScheduler : public Scheduler {
+   public:
+    using Scheduler::Scheduler;
+};
+
+// Blacklists a source that was served bliss_threshold requests in a row,
+// requests of other sources go first until the list is cleared
+class BLISSScheduler : public Scheduler {
+   public:
+    explicit BLISSScheduler(const Config& config);
+    uint64_t Priority(const Command& queued,
+                      const Command& ready) const override;
+    uint64_t MaxPriority() const override { return 3; }
+    void CommandIssued(const Command& cmd, uint64_t clk) override;
+    void ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) override;
+    void SaveState(CheckpointWriter& out) const override;
+    void LoadState(CheckpointReader& in) override;
+
+   private:
+    std::vector<bool> blacklisted_;
+    int last_source_;
+    int streak_;
+};
+
+// Parallelism-aware batch scheduling: up to parbs_batch_cap of the oldest
+// commands per source and bank form a batch that is served before anything
+// else, sources with the least work in the batch are ranked first
+class PARBSScheduler : public Scheduler {
+   public:
+    explicit PARBSScheduler(const Config& config);
+    uint64_t Priority(const Command& queued,
+                      const Command& ready) const override;
+    uint64_t MaxPriority() const override;
+    void CommandIssued(const Command& cmd, uint64_t clk) override;
+    void ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) override;
+    void SaveState(CheckpointWriter& out) const override;
+    void LoadState(CheckpointReader& in) override;
+
+   private:
+    // marked commands still queued, and the rank of each source
+    int num_marked_;
+    std::vector<int> source_rank_;
+    void FormBatch(std::vector<CMDQueue>& queues);
+};
+
+// Adaptive per-thread least-attained-service: sources that used the least
+// bank time, smoothed over atlas_quantum long quanta, go first. Commands
+// waiting longer than atlas_starvation cycles override the ranking.
+class ATLASScheduler : public Scheduler {
+   public:
+    explicit ATLASScheduler(const Config& config);
+    uint64_t Priority(const Command& queued,
+                      const Command& ready) const override;
+    uint64_t MaxPriority() const override;
+    void CommandIssued(const Command& cmd, uint64_t clk) override;
+    void ClockTick(std::vector<CMDQueue>& queues, uint64_t clk) override;
+    void SaveState(CheckpointWriter& out) const override;
+    void LoadState(CheckpointReader& in) override;
+
+   private:
+    uint64_t clk_;
+    std::vector<double> quantum_service_;
+    std::vector<double> total_service_;
+    std::vector<int> source_rank_;
+    void UpdateRanks();
+};
+
+std::unique_ptr<Scheduler> MakeScheduler(const Config& config);
+
+}  // namespace dramsim3
+#endif
@@ -1,10 +1,22 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
 
+#include "checkpoint.h"
 #include "fmt/format.h"
 #include "simple_stats.h"
 
 namespace dramsim3 {
 
+namespace {
+// each has an idle_<cause>_cycles counter
+const char* kBWLossCauses[] = {"empty", "refresh",    "row",
+                               "faw",   "turnaround", "rank_switch",
+                               "sref",  "pd",         "ccd",
+                               "other"};
+}  // namespace
+
 template <class T>
 void PrintStatText(std::ostream& where, std::string name, T value,
                    std::string description) {
@@ -17,13 +29,23 @@ void PrintStatText(std::ostream& where, std::string name, T value,
 }
 
 SimpleStats::SimpleStats(const Config& config, int channel_id)
-    : config_(config), channel_id_(channel_id) {
+    : config_(config),
+      channel_id_(channel_id),
+      in_phase_(false),
+      phases_(Json::array()) {
     // counter stats
     InitStat("num_cycles", "counter", "Number of DRAM cycles");
     InitStat("epoch_num", "counter", "Number of epochs");
-    InitStat("num_reads_done", "counter", "Number of read requests issued");
-    InitStat("num_writes_done", "counter", "Number of read requests issued");
+    InitStat("num_reads_done", "counter", "Number of read bursts done");
+    InitStat("num_writes_done", "counter", "Number of write bursts done");
     InitStat("num_write_buf_hits", "counter", "Number of write buffer hits");
+    InitStat("num_multi_burst_reqs", "counter",
+             "Number of requests split into several bursts");
+    InitStat("num_burst_chops", "counter",
+             "Number of requests fitting a chopped burst (BC4)");
+    InitStat("num_write_drains", "counter", "Number of write drains");
+    InitStat("num_coalesced_writes", "counter",
+             "Number of writes merged into a buffered write");
     InitStat("num_read_row_hits", "counter", "Number of read row buffer hits");
     InitStat("num_write_row_hits", "counter",
              "Number of write row buffer hits");
@@ -32,11 +54,44 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
     InitStat("num_act_cmds", "counter", "Number of ACT commands");
     InitStat("num_pre_cmds", "counter", "Number of PRE commands");
     InitStat("num_ondemand_pres", "counter", "Number of ondemend PRE commands");
+    InitStat("num_timeout_pres", "counter",
+             "Number of PRE commands closing idle rows");
+    InitStat("num_row_mispredicts", "counter",
+             "Number of wrong adaptive row buffer predictions");
     InitStat("num_ref_cmds", "counter", "Number of REF commands");
     InitStat("num_refb_cmds", "counter", "Number of REFb commands");
+    InitStat("num_postponed_refs", "counter",
+             "Number of refreshes postponed for demand traffic");
+    InitStat("num_pulledin_refs", "counter",
+             "Number of refreshes pulled in while idle");
     InitStat("num_srefe_cmds", "counter", "Number of SREFE commands");
     InitStat("num_srefx_cmds", "counter", "Number of SREFX commands");
+    InitStat("num_pde_cmds", "counter", "Number of PDE commands");
+    InitStat("num_pdx_cmds", "counter", "Number of PDX commands");
     InitStat("hbm_dual_cmds", "counter", "Number of cycles dual cmds issued");
+    InitStat("num_same_bankgroup_cols", "counter",
+             "Column commands to the bankgroup of the previous one (tCCD_L)");
+    InitStat("num_diff_bankgroup_cols", "counter",
+             "Column commands to another bankgroup of the same rank (tCCD_S)");
+    InitStat("num_bankgroup_reorders", "counter",
+             "Round robin picks passed over to switch bankgroups");
+    InitStat("num_reads_delayed_by_ref", "counter",
+             "Number of reads whose bank was refreshing while queued");
+    // data bus idle cycles by cause
+    InitStat("idle_empty_cycles", "counter", "Data bus idle, no requests");
+    InitStat("idle_refresh_cycles", "counter", "Data bus idle on refresh");
+    InitStat("idle_row_cycles", "counter",
+             "Data bus idle on tRCD/tRP/tRAS and other bank timing");
+    InitStat("idle_faw_cycles", "counter", "Data bus idle on tFAW/t32AW");
+    InitStat("idle_turnaround_cycles", "counter",
+             "Data bus idle on read/write turnaround");
+    InitStat("idle_rank_switch_cycles", "counter",
+             "Data bus idle on rank switch (tRTRS)");
+    InitStat("idle_sref_cycles", "counter", "Data bus idle on self-refresh");
+    InitStat("idle_pd_cycles", "counter", "Data bus idle on power-down exit");
+    InitStat("idle_ccd_cycles", "counter",
+             "Data bus idle on tCCD_L/tCCD_S");
+    InitStat("idle_other_cycles", "counter", "Data bus idle on scheduling");
 
     // double stats
     InitStat("act_energy", "double", "Activation energy");
@@ -52,6 +107,25 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
                 "rank", config_.ranks);
     InitVecStat("sref_cycles", "vec_counter", "Cyles of rank in SREF mode",
                 "rank", config_.ranks);
+    InitVecStat("act_pd_cycles", "vec_counter",
+                "Cyles of rank in active power-down", "rank", config_.ranks);
+    InitVecStat("pre_pd_cycles", "vec_counter",
+                "Cyles of rank in precharge power-down", "rank", config_.ranks);
+    if (config_.row_hotness) {
+        InitVecStat("bank_act_cmds", "vec_counter", "ACT commands per bank",
+                    "bank", config_.ranks * config_.banks);
+    }
+    if (config_.num_sources > 1) {
+        InitVecStat("source_reads_done", "vec_counter",
+                    "Read requests done per source", "source",
+                    config_.num_sources);
+        InitVecStat("source_writes_done", "vec_counter",
+                    "Write requests done per source", "source",
+                    config_.num_sources);
+        InitVecStat("source_read_cycles", "vec_counter",
+                    "Sum of read latencies (cycles) per source", "source",
+                    config_.num_sources);
+    }
 
     // Vector of double stats
     InitVecStat("act_stb_energy", "vec_double", "Active standby energy", "rank",
@@ -60,12 +134,27 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
                 "rank", config_.ranks);
     InitVecStat("sref_energy", "vec_double", "SREF energy", "rank",
                 config_.ranks);
+    InitVecStat("act_pd_energy", "vec_double", "Active power-down energy",
+                "rank", config_.ranks);
+    InitVecStat("pre_pd_energy", "vec_double", "Precharge power-down energy",
+                "rank", config_.ranks);
 
     // Histogram stats
     InitHistoStat("read_latency", "Read request latency (cycles)", 0, 200, 10);
     InitHistoStat("write_latency", "Write cmd latency (cycles)", 0, 200, 10);
     InitHistoStat("interarrival_latency",
                   "Request interarrival latency (cycles)", 0, 100, 10);
+    // breakdown of read latency by stage
+    InitHistoStat("read_trans_queue_latency",
+                  "Read cycles in transaction queue", 0, 200, 10);
+    InitHistoStat("read_cmd_queue_latency",
+                  "Read cycles in command queue before ACT or column cmd", 0,
+                  200, 10);
+    InitHistoStat("read_row_latency",
+                  "Read cycles from ACT to column cmd (row misses)", 0, 200,
+                  10);
+    InitHistoStat("read_data_latency",
+                  "Read cycles from column cmd to data return", 0, 200, 10);
 
     // some irregular stats
     InitStat("average_bandwidth", "calculated", "Average bandwidth");
@@ -75,6 +164,31 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
              "Average read request latency (cycles)");
     InitStat("average_interarrival", "calculated",
              "Average request interarrival latency (cycles)");
+    InitStat("peak_bandwidth", "calculated", "Peak data bus bandwidth");
+    if (config_.retention_aware) {
+        InitStat("num_skipped_refs", "counter",
+                 "Number of REF commands skipped by retention aware refresh");
+        InitStat("ref_energy_saved", "calculated",
+                 "Refresh energy saved by skipped REF commands");
+        InitStat("ref_bw_saved", "calculated",
+                 "Bandwidth of the rank time skipped REF commands would take");
+    }
+    for (const auto& cause : kBWLossCauses) {
+        InitStat(std::string("bw_loss_") + cause, "calculated",
+                 std::string("Bandwidth lost, data bus idle on ") + cause);
+    }
+
+    // epochs are formatted on the export thread while vec_doubles_ keeps
+    // changing, so formatting walks these fixed lists instead of the maps
+    for (const auto& it : doubles_) {
+        double_names_.push_back(it.first);
+    }
+    for (const auto& it : vec_doubles_) {
+        vec_double_names_.push_back(it.first);
+    }
+    for (const auto& it : calculated_) {
+        calculated_names_.push_back(it.first);
+    }
 }
 
 void SimpleStats::AddValue(const std::string name, const int value) {
@@ -86,14 +200,11 @@ void SimpleStats::AddValue(const std::string name, const int value) {
     }
 }
 
-std::string SimpleStats::GetTextHeader(bool is_final) const {
+std::string SimpleStats::GetTextHeader(const std::string& section) const {
     std::string header =
         "###########################################\n## Statistics of "
         "Channel " +
-        std::to_string(channel_id_);
-    if (!is_final) {
-        header += " of epoch " + std::to_string(counters_.at("epoch_num"));
-    }
+        std::to_string(channel_id_) + section;
     header += "\n###########################################\n";
     return header;
 }
@@ -101,46 +212,151 @@ std::string SimpleStats::GetTextHeader(bool is_final) const {
 double SimpleStats::RankBackgroundEnergy(const int rank) const{
     return vec_doubles_.at("act_stb_energy")[rank] +
            vec_doubles_.at("pre_stb_energy")[rank] +
-           vec_doubles_.at("sref_energy")[rank];
+           vec_doubles_.at("sref_energy")[rank] +
+           vec_doubles_.at("act_pd_energy")[rank] +
+           vec_doubles_.at("pre_pd_energy")[rank];
 }
 
-void SimpleStats::PrintEpochStats() {
-    UpdateEpochStats();
+void SimpleStats::PrintEpochStats(EpochWriter& epoch_writer) {
+    // copy the raw counts, everything else can be done later, possibly on
+    // the export thread
+    auto epoch = std::make_shared<EpochCounts>();
+    epoch->counters = epoch_counters_;
+    epoch->vec_counters = epoch_vec_counters_;
+    epoch->histo_counts = epoch_histo_counts_;
+    epoch->attached_data = std::move(attached_data_);
+    attached_data_ = Json();
+    UpdateBackgroundEnergy(epoch_vec_counters_);
+    UpdateCounters();
+    epoch->epoch_num = counters_.at("epoch_num");
+
     if (config_.output_level >= 1) {
-        std::ofstream j_out(config_.json_epoch_name, std::ofstream::app);
-        j_out << j_data_;
-    }
-    if (config_.output_level >= 2) {
-        std::cout << GetTextHeader(false);
-        for (const auto& it : print_pairs_) {
-            PrintStatText(std::cout, it.first, it.second,
-                          header_descs_[it.first]);
-        }
+        epoch_writer.Submit([this, epoch, &epoch_writer]() {
+            Json j_data;
+            PrintPairs print_pairs;
+            FormatStats(epoch->counters, epoch->vec_counters,
+                        epoch->histo_counts, epoch->attached_data,
+                        epoch->epoch_num, true, j_data, print_pairs);
+            epoch_writer.Write(j_data);
+            if (config_.output_level >= 2) {
+                std::cout << GetTextHeader(
+                    " of epoch " + std::to_string(epoch->epoch_num));
+                for (const auto& it : print_pairs) {
+                    PrintStatText(std::cout, it.first, it.second,
+                                  header_descs_.at(it.first));
+                }
+            }
+        });
     }
-    print_pairs_.clear();
 }
 
 void SimpleStats::PrintFinalStats() {
-    UpdateFinalStats();
+    if (in_phase_) {
+        EndPhase();
+    }
+    UpdateCounters();
+    UpdateBackgroundEnergy(vec_counters_);
+
+    Json j_data;
+    PrintPairs print_pairs;
+    FormatStats(counters_, vec_counters_, histo_counts_, attached_data_,
+                counters_.at("epoch_num"), false, j_data, print_pairs);
+    attached_data_ = Json();
+    if (!phases_.empty()) {
+        j_data["phases"] = phases_;
+    }
 
     if (config_.output_level >= 0) {
         std::ofstream j_out(config_.json_stats_name, std::ofstream::app);
         j_out << "\"" << std::to_string(channel_id_) << "\":";
-        j_out << j_data_;
+        j_out << j_data;
     }
 
     if (config_.output_level >= 1) {
         // HACK: overwrite existing file if this is first channel
         auto perm = channel_id_ == 0 ? std::ofstream::out : std::ofstream::app;
         std::ofstream txt_out(config_.txt_stats_name, perm);
-        txt_out << GetTextHeader(true);
-        for (const auto& it : print_pairs_) {
+        txt_out << GetTextHeader("");
+        for (const auto& it : print_pairs) {
             PrintStatText(txt_out, it.first, it.second,
-                          header_descs_[it.first]);
+                          header_descs_.at(it.first));
+        }
+        for (const auto& phase : phase_text_) {
+            txt_out << GetTextHeader(" of phase " + phase.first);
+            for (const auto& it : phase.second) {
+                PrintStatText(txt_out, it.first, it.second,
+                              header_descs_.at(it.first));
+            }
         }
     }
+}
 
-    print_pairs_.clear();
+SimpleStats::EpochCounts SimpleStats::GetTotals() const {
+    EpochCounts totals;
+    totals.counters = counters_;
+    for (const auto& it : epoch_counters_) {
+        totals.counters[it.first] += it.second;
+    }
+    totals.vec_counters = vec_counters_;
+    for (const auto& it : epoch_vec_counters_) {
+        auto& vec = totals.vec_counters[it.first];
+        for (size_t i = 0; i < vec.size(); i++) {
+            vec[i] += it.second[i];
+        }
+    }
+    totals.histo_counts = histo_counts_;
+    for (const auto& it : epoch_histo_counts_) {
+        auto& counts = totals.histo_counts[it.first];
+        for (const auto& value_count : it.second) {
+            counts[value_count.first] += value_count.second;
+        }
+    }
+    totals.epoch_num = totals.counters.at("epoch_num");
+    return totals;
+}
+
+void SimpleStats::BeginPhase(const std::string& name) {
+    if (in_phase_) {
+        EndPhase();
+    }
+    in_phase_ = true;
+    phase_name_ = name;
+    phase_start_ = GetTotals();
+}
+
+void SimpleStats::EndPhase() {
+    if (!in_phase_) {
+        return;
+    }
+    // what happened since the phase began
+    auto phase = GetTotals();
+    for (auto& it : phase.counters) {
+        it.second -= phase_start_.counters.at(it.first);
+    }
+    for (auto& it : phase.vec_counters) {
+        const auto& start = phase_start_.vec_counters.at(it.first);
+        for (size_t i = 0; i < it.second.size(); i++) {
+            it.second[i] -= start[i];
+        }
+    }
+    for (auto& it : phase.histo_counts) {
+        for (const auto& value_count : phase_start_.histo_counts.at(it.first)) {
+            auto& count = it.second[value_count.first];
+            count -= value_count.second;
+            if (count == 0) {
+                it.second.erase(value_count.first);
+            }
+        }
+    }
+
+    Json j_data;
+    PrintPairs print_pairs;
+    FormatStats(phase.counters, phase.vec_counters, phase.histo_counts, Json(),
+                phase.counters.at("epoch_num"), false, j_data, print_pairs);
+    j_data["phase"] = phase_name_;
+    phases_.push_back(j_data);
+    phase_text_.emplace_back(phase_name_, std::move(print_pairs));
+    in_phase_ = false;
 }
 
 void SimpleStats::Reset() {
@@ -156,21 +372,190 @@ void SimpleStats::Reset() {
     for (auto& vec : epoch_vec_counters_) {
         std::fill(vec.second.begin(), vec.second.end(), 0);
     }
-    for (auto& it : doubles_) {
-        it.second = 0.0;
-    }
     for (auto& vec : vec_doubles_) {
         std::fill(vec.second.begin(), vec.second.end(), 0.0);
     }
-    for (auto& it : calculated_) {
-        it.second = 0.0;
-    }
     for (auto& it : histo_counts_) {
         it.second.clear();
     }
     for (auto& it : epoch_histo_counts_) {
         it.second.clear();
     }
+    if (in_phase_) {
+        phase_start_ = GetTotals();
+    }
+}
+
+StatsSnapshot SimpleStats::GetSnapshot() const {
+    auto vec_counter = [this](const std::string& name, int i) {
+        return vec_counters_.at(name)[i] + epoch_vec_counters_.at(name)[i];
+    };
+
+    StatsSnapshot snapshot;
+    snapshot.tCK = config_.tCK;
+    snapshot.request_size_bytes = config_.request_size_bytes;
+    snapshot.num_cycles = GetCounter("num_cycles");
+    snapshot.num_reads_done = GetCounter("num_reads_done");
+    snapshot.num_writes_done = GetCounter("num_writes_done");
+    snapshot.num_rw_cmds =
+        GetCounter("num_read_cmds") + GetCounter("num_write_cmds");
+    snapshot.num_row_hits =
+        GetCounter("num_read_row_hits") + GetCounter("num_write_row_hits");
+
+    double energy = GetCounter("num_act_cmds") * config_.act_energy_inc +
+                    GetCounter("num_read_cmds") * config_.read_energy_inc +
+                    GetCounter("num_write_cmds") * config_.write_energy_inc +
+                    GetCounter("num_ref_cmds") * config_.ref_energy_inc +
+                    GetCounter("num_refb_cmds") * config_.refb_energy_inc;
+    for (int i = 0; i < config_.ranks; i++) {
+        energy +=
+            vec_counter("rank_active_cycles", i) * config_.act_stb_energy_inc +
+            vec_counter("all_bank_idle_cycles", i) * config_.pre_stb_energy_inc +
+            vec_counter("sref_cycles", i) * config_.sref_energy_inc +
+            vec_counter("act_pd_cycles", i) * config_.act_pd_energy_inc +
+            vec_counter("pre_pd_cycles", i) * config_.pre_pd_energy_inc;
+    }
+    snapshot.total_energy = energy;
+
+    for (const auto& it : histo_counts_.at("read_latency")) {
+        snapshot.read_latency[it.first] += it.second;
+    }
+    for (const auto& it : epoch_histo_counts_.at("read_latency")) {
+        snapshot.read_latency[it.first] += it.second;
+    }
+    return snapshot;
+}
+
+void StatsSnapshot::Merge(const StatsSnapshot& other) {
+    tCK = other.tCK;
+    request_size_bytes = other.request_size_bytes;
+    num_cycles = std::max(num_cycles, other.num_cycles);
+    num_reads_done += other.num_reads_done;
+    num_writes_done += other.num_writes_done;
+    num_rw_cmds += other.num_rw_cmds;
+    num_row_hits += other.num_row_hits;
+    total_energy += other.total_energy;
+    for (const auto& it : other.read_latency) {
+        read_latency[it.first] += it.second;
+    }
+}
+
+StatsSnapshot StatsSnapshot::Since(const StatsSnapshot& start) const {
+    StatsSnapshot diff = *this;
+    diff.num_cycles -= start.num_cycles;
+    diff.num_reads_done -= start.num_reads_done;
+    diff.num_writes_done -= start.num_writes_done;
+    diff.num_rw_cmds -= start.num_rw_cmds;
+    diff.num_row_hits -= start.num_row_hits;
+    diff.total_energy -= start.total_energy;
+    for (const auto& it : start.read_latency) {
+        auto& count = diff.read_latency[it.first];
+        count -= it.second;
+        if (count == 0) {
+            diff.read_latency.erase(it.first);
+        }
+    }
+    return diff;
+}
+
+double StatsSnapshot::Bandwidth() const {
+    double total_time = num_cycles * tCK;
+    if (total_time == 0.0) {
+        return 0.0;
+    }
+    return (num_reads_done + num_writes_done) * request_size_bytes / total_time;
+}
+
+double StatsSnapshot::RowHitRate() const {
+    return num_rw_cmds == 0 ? 0.0
+                            : static_cast<double>(num_row_hits) / num_rw_cmds;
+}
+
+double StatsSnapshot::AverageReadLatency() const {
+    uint64_t accu_sum = 0;
+    uint64_t count = 0;
+    for (const auto& it : read_latency) {
+        accu_sum += it.first * it.second;
+        count += it.second;
+    }
+    return count == 0 ? 0.0 : static_cast<double>(accu_sum) / count;
+}
+
+double StatsSnapshot::ReadLatencyPercentile(double percentile) const {
+    uint64_t count = 0;
+    for (const auto& it : read_latency) {
+        count += it.second;
+    }
+    uint64_t target =
+        static_cast<uint64_t>(std::ceil(count * percentile / 100.0));
+    uint64_t seen = 0;
+    for (const auto& it : read_latency) {
+        seen += it.second;
+        if (seen >= target) {
+            return it.first;
+        }
+    }
+    return 0.0;
+}
+
+double StatsSnapshot::AveragePower() const {
+    double total_time = num_cycles * tCK;
+    return total_time == 0.0 ? 0.0 : total_energy / total_time;
+}
+
+void SimpleStats::SaveState(CheckpointWriter& out) const {
+    out.Write(counters_);
+    out.Write(epoch_counters_);
+    out.Write(vec_counters_);
+    out.Write(epoch_vec_counters_);
+    out.Write(histo_counts_);
+    out.Write(epoch_histo_counts_);
+    out.Write(in_phase_);
+    out.Write(phase_name_);
+    out.Write(phase_start_.counters);
+    out.Write(phase_start_.vec_counters);
+    out.Write(phase_start_.histo_counts);
+    // finished phases are kept in their printed form
+    out.Write(phases_.dump());
+    out.Write(static_cast<uint64_t>(phase_text_.size()));
+    for (const auto& phase : phase_text_) {
+        out.Write(phase.first);
+        out.Write(static_cast<uint64_t>(phase.second.size()));
+        for (const auto& it : phase.second) {
+            out.Write(it.first);
+            out.Write(it.second);
+        }
+    }
+}
+
+void SimpleStats::LoadState(CheckpointReader& in) {
+    in.Read(counters_);
+    in.Read(epoch_counters_);
+    in.Read(vec_counters_);
+    in.Read(epoch_vec_counters_);
+    in.Read(histo_counts_);
+    in.Read(epoch_histo_counts_);
+    in.Read(in_phase_);
+    in.Read(phase_name_);
+    in.Read(phase_start_.counters);
+    in.Read(phase_start_.vec_counters);
+    in.Read(phase_start_.histo_counts);
+    std::string phases;
+    in.Read(phases);
+    phases_ = Json::parse(phases);
+    uint64_t num_phases;
+    in.Read(num_phases);
+    phase_text_.resize(num_phases);
+    for (auto& phase : phase_text_) {
+        in.Read(phase.first);
+        uint64_t num_pairs;
+        in.Read(num_pairs);
+        phase.second.resize(num_pairs);
+        for (auto& it : phase.second) {
+            in.Read(it.first);
+            in.Read(it.second);
+        }
+    }
 }
 
 void SimpleStats::InitStat(std::string name, std::string stat_type,
@@ -227,61 +612,44 @@ void SimpleStats::InitHistoStat(std::string name, std::string description,
     headers.push_back(header);
     header_descs_.emplace(header, description);
 
-    histo_headers_.emplace(name, headers);
-
     // +2 for front and end
-    histo_bins_.emplace(name, std::vector<uint64_t>(num_bins + 2, 0));
-    epoch_histo_bins_.emplace(name, std::vector<uint64_t>(num_bins + 2, 0));
+    histo_headers_.emplace(name, headers);
 }
 
 void SimpleStats::UpdateCounters() {
-    for (const auto& it : epoch_counters_) {
+    for (auto& it : epoch_counters_) {
         counters_[it.first] += it.second;
+        it.second = 0;
     }
-    for (const auto& vec : epoch_vec_counters_) {
+    for (auto& vec : epoch_vec_counters_) {
         for (size_t i = 0; i < vec.second.size(); i++) {
             vec_counters_[vec.first][i] += vec.second[i];
         }
+        std::fill(vec.second.begin(), vec.second.end(), 0);
     }
-}
-
-void SimpleStats::UpdateHistoBins() {
-    for (auto& name_bins : epoch_histo_bins_) {
-        const auto& name = name_bins.first;
-        auto& bins = name_bins.second;
-        std::fill(bins.begin(), bins.end(), 0);
-        for (const auto it : epoch_histo_counts_[name]) {
-            int value = it.first;
-            uint64_t count = it.second;
-            int bin_idx = 0;
-            if (value < histo_bounds_[name].first) {
-                bin_idx = 0;
-            } else if (value > histo_bounds_[name].second) {
-                bin_idx = bins.size() - 1;
-            } else {
-                bin_idx =
-                    (value - histo_bounds_[name].first) / bin_widths_[name] + 1;
-            }
-            bins[bin_idx] += count;
+    for (auto& name_counts : epoch_histo_counts_) {
+        auto& final_counts = histo_counts_[name_counts.first];
+        for (const auto& val_cnt : name_counts.second) {
+            final_counts[val_cnt.first] += val_cnt.second;
         }
+        name_counts.second.clear();
     }
+}
 
-    // update overall histogram counts based on epoch histo counts
-    for (auto& name_counts : epoch_histo_counts_) {
-        const auto& name = name_counts.first;
-        auto& epoch_counts = name_counts.second;
-        auto& final_counts = histo_counts_[name];
-        for (const auto& val_cnt : epoch_counts) {
-            if (final_counts.count(val_cnt.first) <= 0) {
-                final_counts[val_cnt.first] = val_cnt.second;
-            } else {
-                final_counts[val_cnt.first] += val_cnt.second;
-            }
-        }
-        auto& final_bins = histo_bins_[name];
-        for (size_t i = 0; i < final_bins.size(); i++) {
-            final_bins[i] += epoch_histo_bins_[name][i];
-        }
+void SimpleStats::UpdateBackgroundEnergy(const VecStat& vec_counters) {
+    for (int i = 0; i < config_.ranks; i++) {
+        vec_doubles_.at("act_stb_energy")[i] =
+            vec_counters.at("rank_active_cycles")[i] *
+            config_.act_stb_energy_inc;
+        vec_doubles_.at("pre_stb_energy")[i] =
+            vec_counters.at("all_bank_idle_cycles")[i] *
+            config_.pre_stb_energy_inc;
+        vec_doubles_.at("sref_energy")[i] =
+            vec_counters.at("sref_cycles")[i] * config_.sref_energy_inc;
+        vec_doubles_.at("act_pd_energy")[i] =
+            vec_counters.at("act_pd_cycles")[i] * config_.act_pd_energy_inc;
+        vec_doubles_.at("pre_pd_energy")[i] =
+            vec_counters.at("pre_pd_cycles")[i] * config_.pre_pd_energy_inc;
     }
 }
 
@@ -297,33 +665,135 @@ double SimpleStats::GetHistoAvg(const HistoCount& hist_counts) const {
                : static_cast<double>(accu_sum) / static_cast<double>(count);
 }
 
-void SimpleStats::UpdatePrints(bool epoch) {
-    j_data_["channel"] = channel_id_;
+void SimpleStats::FormatStats(
+    const std::unordered_map<std::string, uint64_t>& counters,
+    const VecStat& vec_counters,
+    const std::unordered_map<std::string, HistoCount>& histo_counts,
+    const Json& attached_data, uint64_t epoch_num, bool epoch, Json& j_data,
+    PrintPairs& print_pairs) const {
+    // computed stats
+    std::unordered_map<std::string, double> doubles;
+    for (const auto& name : double_names_) {
+        doubles[name] = 0.0;
+    }
+    doubles["act_energy"] = counters.at("num_act_cmds") * config_.act_energy_inc;
+    doubles["read_energy"] =
+        counters.at("num_read_cmds") * config_.read_energy_inc;
+    doubles["write_energy"] =
+        counters.at("num_write_cmds") * config_.write_energy_inc;
+    doubles["ref_energy"] = counters.at("num_ref_cmds") * config_.ref_energy_inc;
+    doubles["refb_energy"] =
+        counters.at("num_refb_cmds") * config_.refb_energy_inc;
+
+    std::unordered_map<std::string, std::vector<double> > vec_doubles;
+    double background_energy = 0.0;
+    for (const auto& name : vec_double_names_) {
+        vec_doubles[name] = std::vector<double>(config_.ranks, 0.0);
+    }
+    for (int i = 0; i < config_.ranks; i++) {
+        double act_stb = vec_counters.at("rank_active_cycles")[i] *
+                         config_.act_stb_energy_inc;
+        double pre_stb = vec_counters.at("all_bank_idle_cycles")[i] *
+                         config_.pre_stb_energy_inc;
+        double sref_energy =
+            vec_counters.at("sref_cycles")[i] * config_.sref_energy_inc;
+        double act_pd = vec_counters.at("act_pd_cycles")[i] *
+                        config_.act_pd_energy_inc;
+        double pre_pd = vec_counters.at("pre_pd_cycles")[i] *
+                        config_.pre_pd_energy_inc;
+        vec_doubles["act_stb_energy"][i] = act_stb;
+        vec_doubles["pre_stb_energy"][i] = pre_stb;
+        vec_doubles["sref_energy"][i] = sref_energy;
+        vec_doubles["act_pd_energy"][i] = act_pd;
+        vec_doubles["pre_pd_energy"][i] = pre_pd;
+        background_energy += act_stb + pre_stb + sref_energy + act_pd + pre_pd;
+    }
+
+    // histogram bins
+    VecStat histo_bins;
+    for (const auto& name_headers : histo_headers_) {
+        const auto& name = name_headers.first;
+        const auto& bounds = histo_bounds_.at(name);
+        auto& bins = histo_bins[name];
+        bins.resize(name_headers.second.size(), 0);
+        for (const auto& it : histo_counts.at(name)) {
+            int value = it.first;
+            int bin_idx = 0;
+            if (value < bounds.first) {
+                bin_idx = 0;
+            } else if (value > bounds.second) {
+                bin_idx = bins.size() - 1;
+            } else {
+                bin_idx = (value - bounds.first) / bin_widths_.at(name) + 1;
+            }
+            bins[bin_idx] += it.second;
+        }
+    }
+
+    // calculated stats
+    std::unordered_map<std::string, double> calculated;
+    for (const auto& name : calculated_names_) {
+        calculated[name] = 0.0;
+    }
+    uint64_t total_reqs =
+        counters.at("num_reads_done") + counters.at("num_writes_done");
+    double total_time = counters.at("num_cycles") * config_.tCK;
+    double avg_bw = total_reqs * config_.request_size_bytes / total_time;
+    calculated["average_bandwidth"] = avg_bw;
+    if (config_.burst_cycle > 0 && counters.at("num_cycles") > 0) {
+        double peak_bw = config_.request_size_bytes /
+                         (config_.burst_cycle * config_.tCK);
+        calculated["peak_bandwidth"] = peak_bw;
+        for (const auto& cause : kBWLossCauses) {
+            std::string cause_str(cause);
+            double idle = counters.at("idle_" + cause_str + "_cycles");
+            calculated["bw_loss_" + cause_str] =
+                peak_bw * idle / counters.at("num_cycles");
+        }
+    }
 
-    std::unordered_map<std::string, uint64_t>& ref_counters =
-        epoch ? epoch_counters_ : counters_;
-    for (const auto& it : ref_counters) {
-        print_pairs_.emplace_back(it.first, std::to_string(it.second));
-        j_data_[it.first] = it.second;
+    if (config_.retention_aware && counters.at("num_cycles") > 0) {
+        double skipped = counters.at("num_skipped_refs");
+        calculated["ref_energy_saved"] = skipped * config_.ref_energy_inc;
+        calculated["ref_bw_saved"] =
+            calculated["peak_bandwidth"] * skipped * config_.tRFC /
+            (static_cast<double>(counters.at("num_cycles")) * config_.ranks);
     }
-    j_data_["epoch_num"] = counters_["epoch_num"];
 
-    VecStat& ref_vcounter = epoch ? epoch_vec_counters_ : vec_counters_;
-    for (const auto& it : ref_vcounter) {
+    double total_energy = doubles["act_energy"] + doubles["read_energy"] +
+                          doubles["write_energy"] + doubles["ref_energy"] +
+                          doubles["refb_energy"] + background_energy;
+    calculated["total_energy"] = total_energy;
+    calculated["average_power"] = total_energy / counters.at("num_cycles");
+    calculated["average_read_latency"] =
+        GetHistoAvg(histo_counts.at("read_latency"));
+    calculated["average_interarrival"] =
+        GetHistoAvg(histo_counts.at("interarrival_latency"));
+
+    // outputs
+    j_data["channel"] = channel_id_;
+    for (const auto& it : counters) {
+        print_pairs.emplace_back(it.first, std::to_string(it.second));
+        j_data[it.first] = it.second;
+    }
+    j_data["epoch_num"] = epoch_num;
+
+    for (const auto& it : vec_counters) {
         Json j_list;
         for (size_t i = 0; i < it.second.size(); i++) {
             std::string name = it.first + "." + std::to_string(i);
-            print_pairs_.emplace_back(name, std::to_string(it.second[i]));
+            print_pairs.emplace_back(name, std::to_string(it.second[i]));
             j_list[std::to_string(i)] = it.second[i];
         }
-        j_data_[it.first] = j_list;
-    }
-    VecStat& ref_hbins = epoch ? epoch_histo_bins_ : histo_bins_;
-    for (const auto& it : ref_hbins) {
-        const auto& names = histo_headers_[it.first];
-        for (size_t i = 0; i < it.second.size(); i++) {
-            print_pairs_.emplace_back(names[i], std::to_string(it.second[i]));
-            j_data_[names[i]] = it.second[i];
+        j_data[it.first] = j_list;
+    }
+    // walk the member maps so that the output order does not change
+    for (const auto& it : histo_headers_) {
+        const auto& names = it.second;
+        const auto& bins = histo_bins[it.first];
+        for (size_t i = 0; i < names.size(); i++) {
+            print_pairs.emplace_back(names[i], std::to_string(bins[i]));
+            j_data[names[i]] = bins[i];
         }
     }
 
@@ -331,149 +801,41 @@ void SimpleStats::UpdatePrints(bool epoch) {
     // huge therefore we only put aggregated histo in each epoch but
     // complete data at the end
     if (!epoch) {
-        for (const auto& name_hist : histo_counts_) {
+        for (const auto& name_hist : histo_counts) {
             Json j_list;
             for (const auto& it : name_hist.second) {
                 j_list[std::to_string(it.first)] = it.second;
             }
-            j_data_[name_hist.first] = j_list;
+            j_data[name_hist.first] = j_list;
         }
     }
 
-    for (const auto& it : doubles_) {
-        print_pairs_.emplace_back(it.first, fmt::format("{}", it.second));
-        j_data_[it.first] = it.second;
+    for (const auto& name : double_names_) {
+        double val = doubles[name];
+        print_pairs.emplace_back(name, fmt::format("{}", val));
+        j_data[name] = val;
     }
 
-    for (const auto& it : vec_doubles_) {
+    for (const auto& vec_name : vec_double_names_) {
+        const auto& vals = vec_doubles[vec_name];
         Json j_list;
-        for (size_t i = 0; i < it.second.size(); i++) {
-            std::string name = it.first + "." + std::to_string(i);
-            print_pairs_.emplace_back(name, fmt::format("{}", it.second[i]));
-            j_list[std::to_string(i)] = it.second[i];
+        for (size_t i = 0; i < vals.size(); i++) {
+            std::string name = vec_name + "." + std::to_string(i);
+            print_pairs.emplace_back(name, fmt::format("{}", vals[i]));
+            j_list[std::to_string(i)] = vals[i];
         }
-        j_data_[it.first] = j_list;
-    }
-    for (const auto& it : calculated_) {
-        print_pairs_.emplace_back(it.first, fmt::format("{}", it.second));
-        j_data_[it.first] = it.second;
+        j_data[vec_name] = j_list;
     }
-}
-
-void SimpleStats::UpdateEpochStats() {
-    // push counter values as is
-    UpdateCounters();
-
-    // update computed stats
-    doubles_["act_energy"] =
-        epoch_counters_["num_act_cmds"] * config_.act_energy_inc;
-    doubles_["read_energy"] =
-        epoch_counters_["num_read_cmds"] * config_.read_energy_inc;
-    doubles_["write_energy"] =
-        epoch_counters_["num_write_cmds"] * config_.write_energy_inc;
-    doubles_["ref_energy"] =
-        epoch_counters_["num_ref_cmds"] * config_.ref_energy_inc;
-    doubles_["refb_energy"] =
-        epoch_counters_["num_refb_cmds"] * config_.refb_energy_inc;
-
-    // vector doubles, update first, then push
-    double background_energy = 0.0;
-    for (int i = 0; i < config_.ranks; i++) {
-        double act_stb = epoch_vec_counters_["rank_active_cycles"][i] *
-                         config_.act_stb_energy_inc;
-        double pre_stb = epoch_vec_counters_["all_bank_idle_cycles"][i] *
-                         config_.pre_stb_energy_inc;
-        double sref_energy =
-            epoch_vec_counters_["sref_cycles"][i] * config_.sref_energy_inc;
-        vec_doubles_["act_stb_energy"][i] = act_stb;
-        vec_doubles_["pre_stb_energy"][i] = pre_stb;
-        vec_doubles_["sref_energy"][i] = sref_energy;
-        background_energy += act_stb + pre_stb + sref_energy;
-    }
-
-    UpdateHistoBins();
-
-    // calculated stats
-    uint64_t total_reqs =
-        epoch_counters_["num_reads_done"] + epoch_counters_["num_writes_done"];
-    double total_time = epoch_counters_["num_cycles"] * config_.tCK;
-    double avg_bw = total_reqs * config_.request_size_bytes / total_time;
-    calculated_["average_bandwidth"] = avg_bw;
-
-    double total_energy = doubles_["act_energy"] + doubles_["read_energy"] +
-                          doubles_["write_energy"] + doubles_["ref_energy"] +
-                          doubles_["refb_energy"] + background_energy;
-    calculated_["total_energy"] = total_energy;
-    calculated_["average_power"] = total_energy / epoch_counters_["num_cycles"];
-    calculated_["average_read_latency"] =
-        GetHistoAvg(epoch_histo_counts_.at("read_latency"));
-    calculated_["average_interarrival"] =
-        GetHistoAvg(epoch_histo_counts_.at("interarrival_latency"));
-
-    UpdatePrints(true);
-    for (auto& it : epoch_counters_) {
-        it.second = 0;
+    for (const auto& name : calculated_names_) {
+        double val = calculated[name];
+        print_pairs.emplace_back(name, fmt::format("{}", val));
+        j_data[name] = val;
     }
-    for (auto& vec : epoch_vec_counters_) {
-        std::fill(vec.second.begin(), vec.second.end(), 0);
-    }
-    for (auto& it : epoch_histo_counts_) {
-        it.second.clear();
-    }
-    return;
-}
-
-void SimpleStats::UpdateFinalStats() {
-    UpdateCounters();
-
-    // update computed stats
-    doubles_["act_energy"] = counters_["num_act_cmds"] * config_.act_energy_inc;
-    doubles_["read_energy"] =
-        counters_["num_read_cmds"] * config_.read_energy_inc;
-    doubles_["write_energy"] =
-        counters_["num_write_cmds"] * config_.write_energy_inc;
-    doubles_["ref_energy"] = counters_["num_ref_cmds"] * config_.ref_energy_inc;
-    doubles_["refb_energy"] =
-        counters_["num_refb_cmds"] * config_.refb_energy_inc;
-
-    // vector doubles, update first, then push
-    double background_energy = 0.0;
-    for (int i = 0; i < config_.ranks; i++) {
-        double act_stb =
-            vec_counters_["rank_active_cycles"][i] * config_.act_stb_energy_inc;
-        double pre_stb = vec_counters_["all_bank_idle_cycles"][i] *
-                         config_.pre_stb_energy_inc;
-        double sref_energy =
-            vec_counters_["sref_cycles"][i] * config_.sref_energy_inc;
-        vec_doubles_["act_stb_energy"][i] = act_stb;
-        vec_doubles_["pre_stb_energy"][i] = pre_stb;
-        vec_doubles_["sref_energy"][i] = sref_energy;
-        background_energy += act_stb + pre_stb + sref_energy;
+    if (attached_data.is_object()) {
+        for (auto it = attached_data.begin(); it != attached_data.end(); ++it) {
+            j_data[it.key()] = it.value();
+        }
     }
-
-    // histograms
-    UpdateHistoBins();
-
-    // calculated stats
-    uint64_t total_reqs =
-        counters_["num_reads_done"] + counters_["num_writes_done"];
-    double total_time = counters_["num_cycles"] * config_.tCK;
-    double avg_bw = total_reqs * config_.request_size_bytes / total_time;
-    calculated_["average_bandwidth"] = avg_bw;
-
-    double total_energy = doubles_["act_energy"] + doubles_["read_energy"] +
-                          doubles_["write_energy"] + doubles_["ref_energy"] +
-                          doubles_["refb_energy"] + background_energy;
-    calculated_["total_energy"] = total_energy;
-    calculated_["average_power"] = total_energy / counters_["num_cycles"];
-    // calculated_["average_read_latency"] = GetHistoAvg("read_latency");
-    calculated_["average_read_latency"] =
-        GetHistoAvg(histo_counts_.at("read_latency"));
-    calculated_["average_interarrival"] =
-        GetHistoAvg(histo_counts_.at("interarrival_latency"));
-
-    UpdatePrints(false);
-    return;
 }
 
 }  // namespace dramsim3
\ No newline at end of file
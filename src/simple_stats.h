@@ -2,21 +2,65 @@
 #define __SIMPLE_STATS_
 
 #include <fstream>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "configuration.h"
+#include "epoch_writer.h"
 #include "json.hpp"
 
 namespace dramsim3 {
 
+class CheckpointWriter;
+class CheckpointReader;
+
+// Raw totals behind the headline stats at one point in time. Two snapshots
+// can be subtracted to get the stats of the interval in between, and
+// snapshots of different channels can be merged.
+struct StatsSnapshot {
+    StatsSnapshot()
+        : tCK(0.0),
+          request_size_bytes(0),
+          num_cycles(0),
+          num_reads_done(0),
+          num_writes_done(0),
+          num_rw_cmds(0),
+          num_row_hits(0),
+          total_energy(0.0) {}
+    double tCK;
+    int request_size_bytes;
+    uint64_t num_cycles;
+    uint64_t num_reads_done;
+    uint64_t num_writes_done;
+    uint64_t num_rw_cmds;
+    uint64_t num_row_hits;
+    double total_energy;
+    std::map<int, uint64_t> read_latency;
+
+    // channels tick together, so cycles are not summed
+    void Merge(const StatsSnapshot& other);
+    StatsSnapshot Since(const StatsSnapshot& start) const;
+
+    double Bandwidth() const;     // GB/s
+    double RowHitRate() const;
+    double AverageReadLatency() const;  // cycles
+    double ReadLatencyPercentile(double percentile) const;
+    double AveragePower() const;  // mW
+};
+
 class SimpleStats {
    public:
     SimpleStats(const Config& config, int channel_id);
     // incrementing counter
     void Increment(const std::string name) { epoch_counters_[name] += 1; }
 
+    // increment counter by number
+    void IncrementBy(const std::string name, uint64_t num) {
+        epoch_counters_[name] += num;
+    }
+
     // incrementing for vec counter
     void IncrementVec(const std::string name, int pos) {
         epoch_vec_counters_[name][pos] += 1;
@@ -30,11 +74,16 @@ class SimpleStats {
     // add historgram value
     void AddValue(const std::string name, const int value);
 
+    // attach a json record (e.g. hot rows) to the next epoch or final output
+    void AttachData(const std::string name, const nlohmann::json& data) {
+        attached_data_[name] = data;
+    }
+
     // return per rank background energy
     double RankBackgroundEnergy(const int r) const;
 
     // Epoch update
-    void PrintEpochStats();
+    void PrintEpochStats(EpochWriter& epoch_writer);
 
     // Final statas output
     void PrintFinalStats();
@@ -42,10 +91,37 @@ class SimpleStats {
     // Reset (usually after one phase of simulation)
     void Reset();
 
+    // Named region of interest, its stats are printed as a separate
+    // section of the final stats. Beginning a phase ends the open one.
+    void BeginPhase(const std::string& name);
+    void EndPhase();
+
+    // totals including the current, not yet printed, epoch
+    StatsSnapshot GetSnapshot() const;
+    // a single counter, e.g. for tests
+    uint64_t GetCounter(const std::string& name) const {
+        return counters_.at(name) + epoch_counters_.at(name);
+    }
+
+    // only raw counts are saved, derived stats are recomputed on output
+    void SaveState(CheckpointWriter& out) const;
+    void LoadState(CheckpointReader& in);
+
    private:
     using VecStat = std::unordered_map<std::string, std::vector<uint64_t> >;
     using HistoCount = std::unordered_map<int, uint64_t>;
     using Json = nlohmann::json;
+    using PrintPairs = std::vector<std::pair<std::string, std::string> >;
+
+    // raw counts of one epoch, handed over to the epoch writer so that the
+    // derived stats can be computed off the simulation thread
+    struct EpochCounts {
+        std::unordered_map<std::string, uint64_t> counters;
+        VecStat vec_counters;
+        std::unordered_map<std::string, HistoCount> histo_counts;
+        Json attached_data;
+        uint64_t epoch_num;
+    };
     void InitStat(std::string name, std::string stat_type,
                   std::string description);
     void InitVecStat(std::string name, std::string stat_type,
@@ -54,13 +130,22 @@ class SimpleStats {
     void InitHistoStat(std::string name, std::string description, int start_val,
                        int end_val, int num_bins);
 
+    // fold the current epoch into the totals and clear it
     void UpdateCounters();
-    void UpdateHistoBins();
-    void UpdatePrints(bool epoch);
+    void UpdateBackgroundEnergy(const VecStat& vec_counters);
     double GetHistoAvg(const HistoCount& histo_counts) const;
-    std::string GetTextHeader(bool is_final) const;
-    void UpdateEpochStats();
-    void UpdateFinalStats();
+    // section is empty for the final stats, e.g. " of epoch 3" otherwise
+    std::string GetTextHeader(const std::string& section) const;
+    // totals including the current epoch
+    EpochCounts GetTotals() const;
+    // derive energy, bandwidth, histogram bins... from raw counts and
+    // format them, only reads members that are fixed after construction
+    void FormatStats(
+        const std::unordered_map<std::string, uint64_t>& counters,
+        const VecStat& vec_counters,
+        const std::unordered_map<std::string, HistoCount>& histo_counts,
+        const Json& attached_data, uint64_t epoch_num, bool epoch,
+        Json& j_data, PrintPairs& print_pairs) const;
 
     const Config& config_;
     int channel_id_;
@@ -76,16 +161,22 @@ class SimpleStats {
     VecStat vec_counters_;
     VecStat epoch_vec_counters_;
 
-    // NOTE: doubles_ vec_doubles_ and calculated_ are basically one time
-    // placeholders after each epoch they store the value for that epoch
-    // (different from the counters) and in the end updated to the overall value
+    // NOTE: doubles_ and calculated_ only register the names, the values are
+    // derived from the counters whenever stats are printed
     std::unordered_map<std::string, double> doubles_;
 
+    // per rank background energy of the last epoch, or overall after the
+    // final stats, kept up to date for the thermal model
     std::unordered_map<std::string, std::vector<double> > vec_doubles_;
 
     // calculated stats, similar to double, but not the same
     std::unordered_map<std::string, double> calculated_;
 
+    // names of the stats above in map order, fixed after construction
+    std::vector<std::string> double_names_;
+    std::vector<std::string> vec_double_names_;
+    std::vector<std::string> calculated_names_;
+
     // histogram stats
     std::unordered_map<std::string, std::vector<std::string> > histo_headers_;
 
@@ -93,12 +184,17 @@ class SimpleStats {
     std::unordered_map<std::string, int> bin_widths_;
     std::unordered_map<std::string, HistoCount> histo_counts_;
     std::unordered_map<std::string, HistoCount> epoch_histo_counts_;
-    VecStat histo_bins_;
-    VecStat epoch_histo_bins_;
 
-    // outputs
-    Json j_data_;
-    std::vector<std::pair<std::string, std::string> > print_pairs_;
+    // json only, cleared once printed
+    Json attached_data_;
+
+    // totals when the open phase began, and the formatted stats of the
+    // phases that ended so far
+    bool in_phase_;
+    std::string phase_name_;
+    EpochCounts phase_start_;
+    Json phases_;
+    std::vector<std::pair<std::string, PrintPairs> > phase_text_;
 };
 
 }  // namespace dramsim3
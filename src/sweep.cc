@@ -0,0 +1,200 @@
+// In-process design space sweep: one trace, many configs, all cores
+#include <sys/stat.h>
+#include <dirent.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "./../ext/headers/args.hxx"
+#include "fmt/format.h"
+#include "trace_runner.h"
+
+using namespace dramsim3;
+
+namespace {
+struct SweepJob {
+    std::string config_file;
+    std::map<std::string, std::string> overrides;
+    std::string name;
+};
+
+std::string BaseName(const std::string& path) {
+    auto start = path.find_last_of('/');
+    start = start == std::string::npos ? 0 : start + 1;
+    auto end = path.rfind(".ini");
+    return path.substr(start, end == std::string::npos ? end : end - start);
+}
+
+// a directory stands for all .ini files in it
+std::vector<std::string> ExpandConfigs(const std::vector<std::string>& inputs) {
+    std::vector<std::string> configs;
+    for (const auto& input : inputs) {
+        DIR* dir = opendir(input.c_str());
+        if (dir == nullptr) {
+            configs.push_back(input);
+            continue;
+        }
+        std::vector<std::string> files;
+        while (struct dirent* entry = readdir(dir)) {
+            std::string file_name = entry->d_name;
+            if (file_name.size() > 4 &&
+                file_name.compare(file_name.size() - 4, 4, ".ini") == 0) {
+                files.push_back(input + "/" + file_name);
+            }
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end());
+        configs.insert(configs.end(), files.begin(), files.end());
+    }
+    return configs;
+}
+
+// "section.key=v1,v2,v3" adds one dimension to the grid
+std::vector<std::map<std::string, std::string>> BuildGrid(
+    const std::vector<std::string>& grid_specs) {
+    std::vector<std::map<std::string, std::string>> points(1);
+    for (const auto& spec : grid_specs) {
+        auto eq = spec.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Grid spec " << spec
+                      << " is not in section.key=v1,v2 format!" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        std::string key = spec.substr(0, eq);
+        std::vector<std::string> values;
+        std::string rest = spec.substr(eq + 1);
+        size_t pos = 0;
+        while (pos <= rest.size()) {
+            auto comma = rest.find(',', pos);
+            if (comma == std::string::npos) comma = rest.size();
+            values.push_back(rest.substr(pos, comma - pos));
+            pos = comma + 1;
+        }
+        std::vector<std::map<std::string, std::string>> expanded;
+        for (const auto& point : points) {
+            for (const auto& value : values) {
+                auto new_point = point;
+                new_point[key] = value;
+                expanded.push_back(new_point);
+            }
+        }
+        points.swap(expanded);
+    }
+    return points;
+}
+
+std::string OverridesString(const std::map<std::string, std::string>& overrides,
+                            const std::string& kv_sep,
+                            const std::string& sep) {
+    std::string str;
+    for (const auto& it : overrides) {
+        if (!str.empty()) str += sep;
+        str += it.first + kv_sep + it.second;
+    }
+    return str;
+}
+}  // namespace
+
+int main(int argc, const char** argv) {
+    args::ArgumentParser parser(
+        "DRAMSim3 design space sweep, runs every config (and grid point) on "
+        "the same trace in parallel.",
+        "Examples: \n"
+        "./build/dramsim3sweep configs -t sample_trace.txt -o sweep_out\n"
+        "./build/dramsim3sweep configs/DDR4_8Gb_x8_2400.ini -t trace.txt "
+        "-g system.row_buf_policy=OPEN_PAGE,CLOSE_PAGE "
+        "-g system.trans_queue_size=16,32,64");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::ValueFlag<std::string> trace_file_arg(
+        parser, "trace", "Trace file (mandatory)", {'t', "trace"});
+    args::ValueFlagList<std::string> grid_arg(
+        parser, "grid", "Parameter grid dimension, section.key=v1,v2,...",
+        {'g', "grid"});
+    args::ValueFlag<std::string> output_dir_arg(
+        parser, "output_dir", "Output directory, one sub-directory per run",
+        {'o', "output-dir"}, ".");
+    args::ValueFlag<uint64_t> num_cycles_arg(
+        parser, "num_cycles", "Cycle limit per run, 0 runs until drained",
+        {'c', "cycles"}, 0);
+    args::ValueFlag<int> threads_arg(parser, "threads",
+                                     "Number of threads, 0 uses all cores",
+                                     {'j', "threads"}, 0);
+    args::PositionalList<std::string> configs_arg(
+        parser, "configs", "Config files or directories of config files");
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string trace_file = args::get(trace_file_arg);
+    std::vector<std::string> configs = ExpandConfigs(args::get(configs_arg));
+    if (trace_file.empty() || configs.empty()) {
+        std::cerr << parser;
+        return 1;
+    }
+    std::string output_dir = args::get(output_dir_arg);
+    uint64_t max_cycles = args::get(num_cycles_arg);
+    int num_threads = args::get(threads_arg);
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::vector<SweepJob> jobs;
+    auto grid = BuildGrid(args::get(grid_arg));
+    for (const auto& config : configs) {
+        for (const auto& point : grid) {
+            SweepJob job;
+            job.config_file = config;
+            job.overrides = point;
+            job.name = BaseName(config);
+            if (!point.empty()) {
+                job.name += "_" + OverridesString(point, "-", "_");
+            }
+            jobs.push_back(job);
+        }
+    }
+
+    const std::vector<Transaction> trace = LoadTrace(trace_file);
+    std::cout << fmt::format("Running {} jobs over {} requests on {} threads",
+                             jobs.size(), trace.size(), num_threads)
+              << std::endl;
+
+    // every run writes its stats files to its own directory
+    mkdir(output_dir.c_str(), 0755);
+    std::vector<TraceRunResult> results(jobs.size());
+    RunParallel(jobs.size(), num_threads, [&](int i) {
+        std::string job_dir = output_dir + "/" + jobs[i].name;
+        mkdir(job_dir.c_str(), 0755);
+        results[i] = RunTrace(jobs[i].config_file, job_dir, jobs[i].overrides,
+                              trace, max_cycles);
+    });
+
+    std::string csv_name = output_dir + "/sweep.csv";
+    std::ofstream csv(csv_name);
+    csv << "name,config,overrides,cycles,finished,num_reads,num_writes,"
+           "bandwidth,row_hit_rate,average_read_latency,p99_read_latency,"
+           "total_energy,average_power"
+        << std::endl;
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const auto& stats = results[i].stats;
+        csv << fmt::format("{},{},{},{},{},{},{},{},{},{},{},{},{}",
+                           jobs[i].name, jobs[i].config_file,
+                           OverridesString(jobs[i].overrides, "=", ";"),
+                           results[i].cycles, results[i].finished ? 1 : 0,
+                           stats.num_reads_done, stats.num_writes_done,
+                           stats.Bandwidth(), stats.RowHitRate(),
+                           stats.AverageReadLatency(),
+                           stats.ReadLatencyPercentile(99.0),
+                           stats.total_energy, stats.AveragePower())
+            << std::endl;
+    }
+    std::cout << "Results written to " << csv_name << std::endl;
+    return 0;
+}
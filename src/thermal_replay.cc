@@ -8,6 +8,7 @@ ThermalReplay::ThermalReplay(std::string trace_name, std::string config_file,
                              std::string output_dir, uint64_t repeat)
     : config_(config_file, output_dir),
       thermal_calc_(config_),
+      epoch_writer_(config_),
       repeat_(repeat),
       last_clk_(0) {
     for (int i = 0; i < config_.channels; i++) {
@@ -29,7 +30,17 @@ ThermalReplay::ThermalReplay(std::string trace_name, std::string config_file,
         bank_active_.push_back(chan_vec);
     }
 
-    // read commands into memory
+    // read commands into memory, binary traces are read directly
+    CmdTraceReader bin_trace(trace_name);
+    if (bin_trace.IsValid()) {
+        uint64_t clk;
+        Command cmd;
+        while (bin_trace.Next(clk, cmd)) {
+            timed_commands_.push_back(std::pair<uint64_t, Command>(clk, cmd));
+        }
+        return;
+    }
+
     std::ifstream trace_file(trace_name);
     if (!trace_file) {
         std::cout << "cannot open trace file " << trace_name << std::endl;
@@ -46,7 +57,7 @@ ThermalReplay::ThermalReplay(std::string trace_name, std::string config_file,
     trace_file.close();
 }
 
-ThermalReplay::~ThermalReplay() {}
+ThermalReplay::~ThermalReplay() { epoch_writer_.Close(); }
 
 void ThermalReplay::Run() {
     uint64_t clk = 0;
@@ -96,6 +107,8 @@ void ThermalReplay::ParseLine(std::string line, uint64_t &clk, Command &cmd) {
         {"refresh", CommandType::REFRESH},
         {"self_refresh_enter", CommandType::SREF_ENTER},
         {"self_refresh_exit", CommandType::SREF_EXIT},
+        {"power_down_enter", CommandType::PD_ENTER},
+        {"power_down_exit", CommandType::PD_EXIT},
     };
     std::vector<std::string> tokens = StringSplit(line, ' ');
 
@@ -164,6 +177,12 @@ void ThermalReplay::ProcessCMD(Command &cmd, uint64_t clk) {
         case CommandType::SREF_EXIT:
             channel_stats_[channel].Increment("num_srefx_cmds");
             break;
+        case CommandType::PD_ENTER:
+            channel_stats_[channel].Increment("num_pde_cmds");
+            break;
+        case CommandType::PD_EXIT:
+            channel_stats_[channel].Increment("num_pdx_cmds");
+            break;
         default:
             AbruptExit(__FILE__, __LINE__);
     }
@@ -188,7 +207,7 @@ void ThermalReplay::ProcessCMD(Command &cmd, uint64_t clk) {
         for (int c = 0; c < config_.channels; c++) {
             // where to print isn't important here what we really need is the
             // updated stats
-            channel_stats_[c].PrintEpochStats();
+            channel_stats_[c].PrintEpochStats(epoch_writer_);
             for (int r = 0; r < config_.ranks; r++) {
                 double bg_energy = channel_stats_[c].RankBackgroundEnergy(r);
                 thermal_calc_.UpdateBackgroundEnergy(c, r, bg_energy);
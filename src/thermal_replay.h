@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "cmd_trace.h"
 #include "common.h"
 #include "configuration.h"
 #include "simple_stats.h"
@@ -23,6 +24,7 @@ class ThermalReplay {
     std::vector<std::pair<uint64_t, Command>> timed_commands_;
     Config config_;
     ThermalCalculator thermal_calc_;
+    EpochWriter epoch_writer_;
     uint64_t repeat_;
     uint64_t last_clk_;
     std::vector<SimpleStats> channel_stats_;
@@ -58,8 +58,14 @@ Timing::Timing(const Config& config)
 
     int self_refresh_entry_to_exit = config.tCKESR;
     int self_refresh_exit = config.tXS;
-    // int powerdown_to_exit = config.tCKE;
-    // int powerdown_exit = config.tXP;
+    int powerdown_to_exit = config.tCKE;
+    int powerdown_exit = config.tXP;
+    // tRDPDEN, tWRPDEN and tWRAPDEN, the burst (and write recovery) has to
+    // finish before CKE drops; ACT, PRE and REF only need tACTPDEN etc.
+    int read_to_powerdown = config.RL + config.burst_cycle + 1;
+    int write_to_powerdown = write_to_precharge;
+    int writep_to_powerdown = write_to_precharge + 1;
+    int command_to_powerdown = 1;
 
     if (config.bankgroups == 1) {
         // for a bankgroup can be disabled, in that case
@@ -80,7 +86,8 @@ Timing::Timing(const Config& config)
             {CommandType::WRITE, read_to_write},
             {CommandType::READ_PRECHARGE, read_to_read_l},
             {CommandType::WRITE_PRECHARGE, read_to_write},
-            {CommandType::PRECHARGE, read_to_precharge}};
+            {CommandType::PRECHARGE, read_to_precharge},
+            {CommandType::PD_ENTER, read_to_powerdown}};
     other_banks_same_bankgroup[static_cast<int>(CommandType::READ)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::READ, read_to_read_l},
@@ -107,7 +114,8 @@ Timing::Timing(const Config& config)
             {CommandType::WRITE, write_to_write_l},
             {CommandType::READ_PRECHARGE, write_to_read_l},
             {CommandType::WRITE_PRECHARGE, write_to_write_l},
-            {CommandType::PRECHARGE, write_to_precharge}};
+            {CommandType::PRECHARGE, write_to_precharge},
+            {CommandType::PD_ENTER, write_to_powerdown}};
     other_banks_same_bankgroup[static_cast<int>(CommandType::WRITE)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::READ, write_to_read_l},
@@ -133,7 +141,8 @@ Timing::Timing(const Config& config)
             {CommandType::ACTIVATE, readp_to_act},
             {CommandType::REFRESH, read_to_activate},
             {CommandType::REFRESH_BANK, read_to_activate},
-            {CommandType::SREF_ENTER, read_to_activate}};
+            {CommandType::SREF_ENTER, read_to_activate},
+            {CommandType::PD_ENTER, read_to_powerdown}};
     other_banks_same_bankgroup[static_cast<int>(CommandType::READ_PRECHARGE)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::READ, read_to_read_l},
@@ -159,7 +168,8 @@ Timing::Timing(const Config& config)
             {CommandType::ACTIVATE, write_to_activate},
             {CommandType::REFRESH, write_to_activate},
             {CommandType::REFRESH_BANK, write_to_activate},
-            {CommandType::SREF_ENTER, write_to_activate}};
+            {CommandType::SREF_ENTER, write_to_activate},
+            {CommandType::PD_ENTER, writep_to_powerdown}};
     other_banks_same_bankgroup[static_cast<int>(CommandType::WRITE_PRECHARGE)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::READ, write_to_read_l},
@@ -188,6 +198,7 @@ Timing::Timing(const Config& config)
             {CommandType::READ_PRECHARGE, activate_to_read},
             {CommandType::WRITE_PRECHARGE, activate_to_write},
             {CommandType::PRECHARGE, activate_to_precharge},
+            {CommandType::PD_ENTER, command_to_powerdown},
         };
 
     other_banks_same_bankgroup[static_cast<int>(CommandType::ACTIVATE)] =
@@ -206,7 +217,8 @@ Timing::Timing(const Config& config)
             {CommandType::ACTIVATE, precharge_to_activate},
             {CommandType::REFRESH, precharge_to_activate},
             {CommandType::REFRESH_BANK, precharge_to_activate},
-            {CommandType::SREF_ENTER, precharge_to_activate}};
+            {CommandType::SREF_ENTER, precharge_to_activate},
+            {CommandType::PD_ENTER, command_to_powerdown}};
 
     // for those who need tPPD
     if (config.IsGDDR() || config.protocol == DRAMProtocol::LPDDR4) {
@@ -241,16 +253,16 @@ Timing::Timing(const Config& config)
             {CommandType::REFRESH_BANK, refresh_to_refresh},
         };
 
-    // REFRESH, SREF_ENTER and SREF_EXIT are isued to the entire
+    // REFRESH, SREF_ENTER/EXIT and PD_ENTER/EXIT are isued to the entire
     // rank  command REFRESH
     same_rank[static_cast<int>(CommandType::REFRESH)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::ACTIVATE, refresh_to_activate},
             {CommandType::REFRESH, refresh_to_activate},
-            {CommandType::SREF_ENTER, refresh_to_activate}};
+            {CommandType::SREF_ENTER, refresh_to_activate},
+            {CommandType::PD_ENTER, command_to_powerdown}};
 
     // command SREF_ENTER
-    // TODO: add power down commands
     same_rank[static_cast<int>(CommandType::SREF_ENTER)] =
         std::vector<std::pair<CommandType, int> >{
             {CommandType::SREF_EXIT, self_refresh_entry_to_exit}};
@@ -261,7 +273,27 @@ Timing::Timing(const Config& config)
             {CommandType::ACTIVATE, self_refresh_exit},
             {CommandType::REFRESH, self_refresh_exit},
             {CommandType::REFRESH_BANK, self_refresh_exit},
-            {CommandType::SREF_ENTER, self_refresh_exit}};
+            {CommandType::SREF_ENTER, self_refresh_exit},
+            {CommandType::PD_ENTER, self_refresh_exit}};
+
+    // command PD_ENTER, stays in power-down for at least tCKE
+    same_rank[static_cast<int>(CommandType::PD_ENTER)] =
+        std::vector<std::pair<CommandType, int> >{
+            {CommandType::PD_EXIT, powerdown_to_exit}};
+
+    // command PD_EXIT, any command waits tXP after waking up
+    same_rank[static_cast<int>(CommandType::PD_EXIT)] =
+        std::vector<std::pair<CommandType, int> >{
+            {CommandType::ACTIVATE, powerdown_exit},
+            {CommandType::READ, powerdown_exit},
+            {CommandType::READ_PRECHARGE, powerdown_exit},
+            {CommandType::WRITE, powerdown_exit},
+            {CommandType::WRITE_PRECHARGE, powerdown_exit},
+            {CommandType::PRECHARGE, powerdown_exit},
+            {CommandType::REFRESH, powerdown_exit},
+            {CommandType::REFRESH_BANK, powerdown_exit},
+            {CommandType::SREF_ENTER, powerdown_exit},
+            {CommandType::PD_ENTER, powerdown_exit}};
 }
 
 }  // namespace dramsim3
@@ -0,0 +1,83 @@
+#include "trace_runner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "addr_trace.h"
+#include "memory_system.h"
+
+namespace dramsim3 {
+
+std::vector<Transaction> LoadTrace(const std::string& trace_file) {
+    AddrTraceReader trace(trace_file);
+    if (!trace.IsOpen()) {
+        std::cerr << "Trace file does not exist" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    std::vector<Transaction> transactions;
+    Transaction trans;
+    while (trace.Next(trans)) {
+        transactions.push_back(trans);
+    }
+    return transactions;
+}
+
+TraceRunResult RunTrace(const std::string& config_file,
+                        const std::string& output_dir,
+                        const std::map<std::string, std::string>& overrides,
+                        const std::vector<Transaction>& trace,
+                        uint64_t max_cycles) {
+    uint64_t num_done = 0;
+    auto callback = [&num_done](uint64_t addr) { num_done++; };
+    MemorySystem memory_system(config_file, output_dir, overrides, callback,
+                               callback);
+
+    uint64_t clk = 0;
+    size_t next = 0;
+    while (next < trace.size() || num_done < next) {
+        if (max_cycles > 0 && clk >= max_cycles) {
+            break;
+        }
+        memory_system.ClockTick();
+        if (next < trace.size() && trace[next].added_cycle <= clk) {
+            const auto& trans = trace[next];
+            if (memory_system.WillAcceptTransaction(trans.addr,
+                                                    trans.is_write)) {
+                memory_system.AddTransaction(trans.addr, trans.is_write);
+                next++;
+            }
+        }
+        clk++;
+    }
+
+    TraceRunResult result;
+    result.cycles = clk;
+    result.finished = next == trace.size() && num_done >= next;
+    result.stats = memory_system.GetStatsSnapshot();
+    memory_system.PrintStats();
+    return result;
+}
+
+void RunParallel(int num_jobs, int num_threads,
+                 const std::function<void(int)>& job) {
+    std::atomic<int> next_job(0);
+    auto worker = [&]() {
+        int i;
+        while ((i = next_job.fetch_add(1)) < num_jobs) {
+            job(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < std::max(1, num_threads) - 1; i++) {
+        threads.emplace_back(worker);
+    }
+    // the calling thread works as well
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,39 @@
+#ifndef DRAMSIM3_TRACE_RUNNER_H
+#define DRAMSIM3_TRACE_RUNNER_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "simple_stats.h"
+
+namespace dramsim3 {
+
+// Helpers for running many simulations of the same trace in one process.
+// The trace is parsed once and shared read-only by all runs.
+std::vector<Transaction> LoadTrace(const std::string& trace_file);
+
+struct TraceRunResult {
+    uint64_t cycles;
+    // false if max_cycles was hit before the trace was drained
+    bool finished;
+    StatsSnapshot stats;
+};
+
+// Replays the trace the same way TraceBasedCPU does and runs until every
+// request has completed or max_cycles (0 for no limit) is reached. Final
+// stats files are written to output_dir.
+TraceRunResult RunTrace(const std::string& config_file,
+                        const std::string& output_dir,
+                        const std::map<std::string, std::string>& overrides,
+                        const std::vector<Transaction>& trace,
+                        uint64_t max_cycles);
+
+// runs job(0) ... job(num_jobs - 1) on num_threads worker threads
+void RunParallel(int num_jobs, int num_threads,
+                 const std::function<void(int)>& job);
+
+}  // namespace dramsim3
+
+#endif  // DRAMSIM3_TRACE_RUNNER_H
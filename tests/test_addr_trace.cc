@@ -0,0 +1,74 @@
+#include <cstdio>
+#include <fstream>
+#include "addr_trace.h"
+#include "catch.hpp"
+
+TEST_CASE("Address trace ROI markers", "[addrtrace][dramsim3]") {
+    using dramsim3::TraceRecord;
+    using dramsim3::TraceRecordType;
+
+    SECTION("TEST text traces") {
+        const char* file_name = "test_roi.trace";
+        {
+            std::ofstream out(file_name);
+            out << "ROI_BEGIN warmup 0\n"
+                << "0x40 READ 5\n"
+                << "\n"
+                << "ROI_END 10\n"
+                << "0x80 WRITE 12\n";
+        }
+        dramsim3::AddrTraceReader reader(file_name);
+        REQUIRE(reader.IsOpen());
+        REQUIRE(!reader.IsBinary());
+        TraceRecord record;
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::ROI_BEGIN);
+        REQUIRE(record.roi_name == "warmup");
+        REQUIRE(record.trans.added_cycle == 0);
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::REQUEST);
+        REQUIRE(record.trans.addr == 0x40);
+        REQUIRE(!record.trans.is_write);
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::ROI_END);
+        REQUIRE(record.trans.added_cycle == 10);
+        // request only reads skip the markers
+        dramsim3::AddrTraceReader requests(file_name);
+        dramsim3::Transaction trans;
+        REQUIRE(requests.Next(trans));
+        REQUIRE(requests.Next(trans));
+        REQUIRE(trans.addr == 0x80);
+        REQUIRE(trans.is_write);
+        REQUIRE(trans.added_cycle == 12);
+        REQUIRE(!requests.Next(trans));
+        std::remove(file_name);
+    }
+
+    SECTION("TEST binary traces") {
+        const char* file_name = "test_roi.bin";
+        {
+            dramsim3::AddrTraceWriter writer(file_name);
+            writer.WriteMarker(TraceRecordType::ROI_BEGIN, "application", 3);
+            writer.Write(0x1000, true, 7, 42);
+            writer.WriteMarker(TraceRecordType::ROI_END, "", 9);
+        }
+        dramsim3::AddrTraceReader reader(file_name);
+        REQUIRE(reader.IsBinary());
+        TraceRecord record;
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::ROI_BEGIN);
+        // names are cut to the 8 bytes of the address field
+        REQUIRE(record.roi_name == "applicat");
+        REQUIRE(record.trans.added_cycle == 3);
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::REQUEST);
+        REQUIRE(record.trans.addr == 0x1000);
+        REQUIRE(record.trans.is_write);
+        REQUIRE(record.tag == 42);
+        REQUIRE(reader.Next(record));
+        REQUIRE(record.type == TraceRecordType::ROI_END);
+        REQUIRE(record.roi_name.empty());
+        REQUIRE(!reader.Next(record));
+        std::remove(file_name);
+    }
+}
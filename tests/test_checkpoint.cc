@@ -0,0 +1,80 @@
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "catch.hpp"
+#include "memory_system.h"
+
+namespace {
+// issue a deterministic mix of reads and writes to both systems and
+// record when each of them completes
+void RunTraffic(dramsim3::MemorySystem& mem, std::vector<uint64_t>& done,
+                uint64_t seed, int cycles) {
+    uint64_t addr = seed;
+    for (int i = 0; i < cycles; i++) {
+        addr = addr * 6364136223846793005ULL + 1442695040888963407ULL;
+        uint64_t hex_addr = (addr >> 20) & 0xFFFFFC0;
+        bool is_write = (addr >> 60) == 0;
+        if (i % 3 == 0 && mem.WillAcceptTransaction(hex_addr, is_write)) {
+            mem.AddTransaction(hex_addr, is_write);
+        }
+        mem.ClockTick();
+    }
+}
+}  // namespace
+
+TEST_CASE("Checkpoint and restore", "[checkpoint][dramsim3]") {
+    std::vector<uint64_t> orig_done, restored_done;
+    auto orig_cb = [&orig_done](uint64_t addr) { orig_done.push_back(addr); };
+    auto restored_cb = [&restored_done](uint64_t addr) {
+        restored_done.push_back(addr);
+    };
+    dramsim3::MemorySystem orig("configs/DDR4_8Gb_x8_2400.ini", ".", orig_cb,
+                                orig_cb);
+    dramsim3::MemorySystem restored("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                    restored_cb, restored_cb);
+
+    SECTION("TEST restored system behaves like the original") {
+        RunTraffic(orig, orig_done, 1, 20000);
+        REQUIRE(orig.SaveCheckpoint("test_checkpoint.ckpt"));
+        REQUIRE(restored.LoadCheckpoint("test_checkpoint.ckpt"));
+
+        orig_done.clear();
+        RunTraffic(orig, orig_done, 2, 20000);
+        RunTraffic(restored, restored_done, 2, 20000);
+        REQUIRE(!orig_done.empty());
+        REQUIRE(orig_done == restored_done);
+        std::remove("test_checkpoint.ckpt");
+    }
+
+    SECTION("TEST fast-forward and host clock state are restored") {
+        orig.SetHostFrequency(3000);
+        restored.SetHostFrequency(3000);
+        orig.StartFastForward(1000, 0);
+        orig.AdvanceHostCycles(5);
+        // warmed but not yet returned
+        orig.AddTransaction(0x40, false);
+        orig.AddTransaction(0x80, true);
+        REQUIRE(orig.SaveCheckpoint("test_checkpoint.ckpt"));
+        REQUIRE(restored.LoadCheckpoint("test_checkpoint.ckpt"));
+        REQUIRE(restored.IsFastForwarding());
+
+        orig_done.clear();
+        for (int i = 0; i < 3000; i++) {
+            orig.Tick();
+            restored.Tick();
+            REQUIRE(orig.IsFastForwarding() == restored.IsFastForwarding());
+        }
+        REQUIRE(!restored.IsFastForwarding());
+        REQUIRE(orig_done == std::vector<uint64_t>{0x40, 0x80});
+        REQUIRE(restored_done == orig_done);
+        std::remove("test_checkpoint.ckpt");
+    }
+
+    SECTION("TEST mismatching organization is rejected") {
+        dramsim3::MemorySystem other("configs/HBM1_4Gb_x128.ini", ".",
+                                     restored_cb, restored_cb);
+        REQUIRE(orig.SaveCheckpoint("test_checkpoint.ckpt"));
+        REQUIRE(!other.LoadCheckpoint("test_checkpoint.ckpt"));
+        std::remove("test_checkpoint.ckpt");
+    }
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+#include "clock_domain.h"
+#include "memory_system.h"
+
+bool clock_call_back_called = false;
+
+void clock_call_back(uint64_t addr) {
+    clock_call_back_called = true;
+    return;
+}
+
+TEST_CASE("Clock domain crossing", "[clock]") {
+    SECTION("TEST same frequency is 1:1") {
+        dramsim3::ClockDomainCrosser crosser(625, 625);
+        REQUIRE(crosser.AdvanceParent(1) == 1);
+        REQUIRE(crosser.AdvanceParent(1000) == 1000);
+    }
+
+    SECTION("TEST faster host does not drift") {
+        // 4GHz host on a 1.6GHz DRAM clock, ratio 2.5
+        dramsim3::ClockDomainCrosser crosser(250, 625);
+        uint64_t total = 0;
+        for (int i = 0; i < 1000; i++) {
+            total += crosser.AdvanceParent(1);
+        }
+        REQUIRE(total == 400);
+    }
+
+    SECTION("TEST batched advance matches per cycle advance") {
+        dramsim3::ClockDomainCrosser single(333, 1250);
+        dramsim3::ClockDomainCrosser batch(333, 1250);
+        uint64_t total = 0;
+        for (int i = 0; i < 12345; i++) {
+            total += single.AdvanceParent(1);
+        }
+        REQUIRE(batch.AdvanceParent(12345) == total);
+    }
+
+    SECTION("TEST periods that are not whole ps do not drift") {
+        // 3GHz host on a 0.75ns DRAM clock, 9 host cycles are 4 DRAM cycles
+        dramsim3::ClockDomainCrosser crosser(1, 1);
+        crosser.SetClocks(3000, 0.75);
+        REQUIRE(crosser.ParentPeriod() == 4);
+        REQUIRE(crosser.ChildPeriod() == 9);
+        uint64_t total = 0;
+        for (int i = 0; i < 900000; i++) {
+            total += crosser.AdvanceParent(1);
+        }
+        REQUIRE(total == 400000);
+    }
+
+    SECTION("TEST huge batches do not overflow") {
+        dramsim3::ClockDomainCrosser crosser(1, 1);
+        crosser.SetClocks(2933.333, 0.682);
+        // floor(2^40 * 10^12 / (682000 * 2933333))
+        REQUIRE(crosser.AdvanceParent(1ULL << 40) == 549609313876ULL);
+    }
+}
+
+TEST_CASE("Memory system host clock", "[clock][dramsim3]") {
+    dramsim3::MemorySystem dram_clocked("configs/HBM1_4Gb_x128.ini", ".",
+                                        clock_call_back, clock_call_back);
+    dramsim3::MemorySystem host_clocked("configs/HBM1_4Gb_x128.ini", ".",
+                                        clock_call_back, clock_call_back);
+
+    SECTION("TEST host cycles are converted to DRAM cycles") {
+        clock_call_back_called = false;
+        dram_clocked.AddTransaction(1, false);
+        int dram_clk = 0;
+        while (!clock_call_back_called && dram_clk < 1000) {
+            dram_clocked.ClockTick();
+            dram_clk++;
+        }
+
+        // HBM1 tCK is 2ns so a 2GHz host runs 4 cycles per DRAM cycle
+        clock_call_back_called = false;
+        host_clocked.SetHostFrequency(2000);
+        host_clocked.AddTransaction(1, false);
+        int host_clk = 0;
+        while (!clock_call_back_called && host_clk < 4000) {
+            host_clocked.Tick();
+            host_clk++;
+        }
+        REQUIRE(host_clk == dram_clk * 4);
+    }
+}
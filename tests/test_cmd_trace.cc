@@ -0,0 +1,47 @@
+#include <cstdio>
+#include "catch.hpp"
+#include "cmd_trace.h"
+
+TEST_CASE("Binary command trace", "[cmdtrace]") {
+    using dramsim3::Address;
+    using dramsim3::Command;
+    using dramsim3::CommandType;
+
+    SECTION("TEST commands round trip, including whole-rank commands") {
+        const char* file_name = "test_cmd.bin";
+        {
+            dramsim3::CmdTraceWriter writer;
+            writer.Open(file_name);
+            writer.Write(5, Command(CommandType::ACTIVATE,
+                                    Address(1, 0, 2, 3, 1234, 0), 0));
+            writer.Write(9, Command(CommandType::REFRESH,
+                                    Address(1, 1, -1, -1, -1, -1), 0));
+            writer.Write(12, Command(CommandType::SREF_ENTER, Address(), 0));
+            writer.Close();
+        }
+        dramsim3::CmdTraceReader reader(file_name);
+        REQUIRE(reader.IsValid());
+        uint64_t clk;
+        Command cmd;
+        REQUIRE(reader.Next(clk, cmd));
+        REQUIRE(clk == 5);
+        REQUIRE(cmd.cmd_type == CommandType::ACTIVATE);
+        REQUIRE(cmd.Channel() == 1);
+        REQUIRE(cmd.Bankgroup() == 2);
+        REQUIRE(cmd.Bank() == 3);
+        REQUIRE(cmd.Row() == 1234);
+        REQUIRE(reader.Next(clk, cmd));
+        REQUIRE(clk == 9);
+        REQUIRE(cmd.cmd_type == CommandType::REFRESH);
+        REQUIRE(cmd.Rank() == 1);
+        REQUIRE(cmd.Bankgroup() == -1);
+        REQUIRE(cmd.Bank() == -1);
+        REQUIRE(cmd.Row() == -1);
+        REQUIRE(reader.Next(clk, cmd));
+        REQUIRE(cmd.cmd_type == CommandType::SREF_ENTER);
+        REQUIRE(cmd.Channel() == -1);
+        REQUIRE(cmd.Rank() == -1);
+        REQUIRE(!reader.Next(clk, cmd));
+        std::remove(file_name);
+    }
+}
@@ -93,3 +93,70 @@ TEST_CASE("Address Mapping", "[config]") {
     }
 }
 
+
+TEST_CASE("Config overrides", "[config]") {
+    dramsim3::Config config(
+        "configs/HBM1_4Gb_x128.ini", ".",
+        {{"system.row_buf_policy", "CLOSE_PAGE"},
+         {"system.trans_queue_size", "64"},
+         {"system.address_mapping", "rochrababgco"}});
+
+    SECTION("TEST overrides replace file values") {
+        REQUIRE(config.row_buf_policy == "CLOSE_PAGE");
+        REQUIRE(config.trans_queue_size == 64);
+        REQUIRE(config.address_mapping == "rochrababgco");
+    }
+
+    SECTION("TEST write buffer follows the transaction queue by default") {
+        REQUIRE(config.write_buf_size == 64);
+        REQUIRE(config.write_high_watermark == 64);
+        REQUIRE(config.write_low_watermark == 0);
+        REQUIRE(!config.write_coalescing);
+    }
+}
+
+TEST_CASE("Fine granularity refresh", "[config]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                            {{"system.refresh_mode", "4"}});
+
+    SECTION("TEST 4x mode refreshes four times as often for tRFC4") {
+        REQUIRE(config.tRFC == config.tRFC4);
+        REQUIRE(config.tRFC4 == 192);
+        REQUIRE(config.tREFI == 9360 / 4);
+    }
+}
+
+TEST_CASE("XOR address hash", "[config]") {
+    dramsim3::Config plain("configs/DDR4_8Gb_x8_2400.ini", ".");
+    int ba_bit = plain.ba_pos + plain.shift_bits;
+    int ro_bit = plain.ro_pos + plain.shift_bits;
+    std::string ba_hash = std::to_string(ba_bit) + "^" +
+                          std::to_string(ro_bit) + ", " +
+                          std::to_string(ba_bit + 1) + "^" +
+                          std::to_string(ro_bit + 1);
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                            {{"system.ba_hash", ba_hash}});
+
+    SECTION("TEST a row stride no longer hammers one bank") {
+        std::vector<int> banks;
+        for (uint64_t row = 0; row < 4; row++) {
+            uint64_t hex_addr = row << ro_bit;
+            REQUIRE(plain.AddressMapping(hex_addr).bank == 0);
+            auto addr = config.AddressMapping(hex_addr);
+            REQUIRE(addr.row == static_cast<int>(row));
+            banks.push_back(addr.bank);
+        }
+        REQUIRE(banks == std::vector<int>({0, 1, 2, 3}));
+    }
+
+    SECTION("TEST unhashed fields keep the plain layout") {
+        uint64_t hex_addr = 0x12345678c0;
+        auto hashed = config.AddressMapping(hex_addr);
+        auto addr = plain.AddressMapping(hex_addr);
+        REQUIRE(hashed.bankgroup == addr.bankgroup);
+        REQUIRE(hashed.column == addr.column);
+        REQUIRE(hashed.row == addr.row);
+        REQUIRE(hashed.bank == (addr.bank ^ (addr.row & 3)));
+        REQUIRE(config.Channel(hex_addr) == hashed.channel);
+    }
+}
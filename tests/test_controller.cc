@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "catch.hpp"
+#include "configuration.h"
+#include "controller.h"
+#include "timing.h"
+
+namespace {
+const char* kIdleCounters[] = {
+    "idle_empty_cycles",      "idle_refresh_cycles",
+    "idle_row_cycles",        "idle_faw_cycles",
+    "idle_turnaround_cycles", "idle_rank_switch_cycles",
+    "idle_sref_cycles",       "idle_pd_cycles",
+    "idle_ccd_cycles",        "idle_other_cycles"};
+
+// returns finished requests first, like JedecDRAMSystem
+void Tick(dramsim3::Controller& ctrl, uint64_t& clk, int cycles) {
+    for (int i = 0; i < cycles; i++, clk++) {
+        while (ctrl.ReturnDoneTrans(clk).second >= 0) {
+        }
+        ctrl.ClockTick();
+    }
+}
+
+// the final stats of channel 0
+nlohmann::json ReadStats(const dramsim3::Config& config) {
+    std::ifstream in(config.json_stats_name);
+    std::stringstream text;
+    text << "{" << in.rdbuf() << "}";
+    std::remove(config.json_stats_name.c_str());
+    std::remove(config.txt_stats_name.c_str());
+    return nlohmann::json::parse(text.str())["0"];
+}
+
+uint64_t HistoValue(const nlohmann::json& histo) {
+    REQUIRE(histo.size() == 1);
+    return std::stoull(histo.begin().key());
+}
+}  // namespace
+
+TEST_CASE("Controller", "[controller]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                            {{"other.output_prefix", "test_controller"}});
+    dramsim3::Timing timing(config);
+    uint64_t clk = 0;
+
+    SECTION("TEST idle data bus cycles add up by cause") {
+        dramsim3::Controller ctrl(0, config, timing);
+        Tick(ctrl, clk, 10);
+        // a read to a closed bank waits tRCD after its ACT
+        ctrl.AddTransaction(dramsim3::Transaction(0, false));
+        Tick(ctrl, clk, 90);
+        uint64_t idle = 0;
+        for (auto name : kIdleCounters) {
+            idle += ctrl.GetCounter(name);
+        }
+        REQUIRE(idle == ctrl.GetCounter("num_cycles") - config.burst_cycle);
+        REQUIRE(ctrl.GetCounter("idle_row_cycles") ==
+                static_cast<uint64_t>(config.tRCD));
+    }
+
+    SECTION("TEST read stage latencies add up to the read latency") {
+        dramsim3::Controller ctrl(0, config, timing);
+        Tick(ctrl, clk, 10);
+        ctrl.AddTransaction(dramsim3::Transaction(0, false));
+        Tick(ctrl, clk, 90);
+        ctrl.PrintFinalStats();
+        auto stats = ReadStats(config);
+        REQUIRE(stats["num_reads_done"] == 1);
+        uint64_t stages = 0;
+        for (auto name : {"read_trans_queue_latency", "read_cmd_queue_latency",
+                          "read_row_latency", "read_data_latency"}) {
+            stages += HistoValue(stats[name]);
+        }
+        REQUIRE(stages == HistoValue(stats["read_latency"]));
+        REQUIRE(HistoValue(stats["read_row_latency"]) ==
+                static_cast<uint64_t>(config.tRCD));
+    }
+
+    SECTION("TEST a phase counts what happened between its markers") {
+        dramsim3::Controller ctrl(0, config, timing);
+        ctrl.AddTransaction(dramsim3::Transaction(0, false));
+        Tick(ctrl, clk, 100);
+        auto start = ctrl.GetStatsSnapshot();
+        ctrl.BeginPhase("roi");
+        for (int i = 1; i <= 4; i++) {
+            ctrl.AddTransaction(dramsim3::Transaction(i << 6, i % 2 == 0));
+        }
+        Tick(ctrl, clk, 100);
+        ctrl.EndPhase();
+        auto roi = ctrl.GetStatsSnapshot().Since(start);
+        Tick(ctrl, clk, 50);
+        ctrl.PrintFinalStats();
+        auto phase = ReadStats(config)["phases"][0];
+        REQUIRE(phase["phase"] == "roi");
+        REQUIRE(roi.num_reads_done == 2);
+        REQUIRE(roi.num_writes_done == 2);
+        REQUIRE(phase["num_cycles"] == roi.num_cycles);
+        REQUIRE(phase["num_reads_done"] == roi.num_reads_done);
+        REQUIRE(phase["num_writes_done"] == roi.num_writes_done);
+        uint64_t row_hits = phase["num_read_row_hits"].get<uint64_t>() +
+                            phase["num_write_row_hits"].get<uint64_t>();
+        REQUIRE(row_hits == roi.num_row_hits);
+    }
+
+    SECTION("TEST TIMEOUT closes a row after row_timeout idle cycles") {
+        dramsim3::Config timeout_config(
+            "configs/DDR4_8Gb_x8_2400.ini", ".",
+            {{"system.row_buf_policy", "TIMEOUT"},
+             {"system.row_timeout", "50"}});
+        dramsim3::Controller ctrl(0, timeout_config, timing);
+        ctrl.AddTransaction(dramsim3::Transaction(0, false));
+        while (ctrl.GetCounter("num_read_cmds") == 0) {
+            Tick(ctrl, clk, 1);
+        }
+        // the read went out in the last cycle
+        uint64_t access_clk = clk - 1;
+        Tick(ctrl, clk, access_clk + timeout_config.row_timeout - clk);
+        REQUIRE(ctrl.GetCounter("num_timeout_pres") == 0);
+        REQUIRE(ctrl.GetCounter("num_pre_cmds") == 0);
+        Tick(ctrl, clk, 1);
+        REQUIRE(ctrl.GetCounter("num_timeout_pres") == 1);
+        REQUIRE(ctrl.GetCounter("num_pre_cmds") == 1);
+    }
+}
@@ -0,0 +1,35 @@
+#include <cstdio>
+#include <fstream>
+#include "catch.hpp"
+#include "configuration.h"
+#include "epoch_writer.h"
+
+namespace {
+nlohmann::json ReadEpochs(const std::string& file_name) {
+    std::ifstream in(file_name);
+    nlohmann::json j;
+    in >> j;
+    return j;
+}
+}  // namespace
+
+TEST_CASE("Epoch writer", "[epoch]") {
+    SECTION("TEST epochs after a flush are appended to the JSON array") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"other.output_prefix", "test_epochs"}});
+        {
+            dramsim3::EpochWriter writer(config);
+            writer.Write({{"epoch_num", 0}});
+            writer.Write({{"epoch_num", 1}});
+            // e.g. final stats printed in the middle of a run
+            writer.Flush();
+            REQUIRE(ReadEpochs(config.epoch_stats_name).size() == 2);
+            writer.Write({{"epoch_num", 2}});
+            writer.Close();
+        }
+        auto epochs = ReadEpochs(config.epoch_stats_name);
+        REQUIRE(epochs.size() == 3);
+        REQUIRE(epochs[2]["epoch_num"] == 2);
+        std::remove(config.epoch_stats_name.c_str());
+    }
+}
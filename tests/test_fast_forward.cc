@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "memory_system.h"
+
+namespace {
+bool ff_call_back_called = false;
+void ff_call_back(uint64_t addr) { ff_call_back_called = true; }
+
+int ReadLatency(dramsim3::MemorySystem& mem, uint64_t hex_addr) {
+    ff_call_back_called = false;
+    mem.AddTransaction(hex_addr, false);
+    int clk = 0;
+    while (!ff_call_back_called && clk < 1000) {
+        mem.ClockTick();
+        clk++;
+    }
+    return clk;
+}
+}  // namespace
+
+TEST_CASE("Fast-forward warm-up", "[fastforward][dramsim3]") {
+    dramsim3::MemorySystem cold("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                ff_call_back, ff_call_back);
+    dramsim3::MemorySystem warm("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                ff_call_back, ff_call_back);
+
+    SECTION("TEST requests complete on the next tick") {
+        warm.StartFastForward(0, 0);
+        ff_call_back_called = false;
+        REQUIRE(warm.WillAcceptTransaction(0x1000, true));
+        warm.AddTransaction(0x1000, true);
+        REQUIRE(!ff_call_back_called);
+        warm.ClockTick();
+        REQUIRE(ff_call_back_called);
+        REQUIRE(warm.IsFastForwarding());
+    }
+
+    SECTION("TEST switching to detailed mode at the markers") {
+        warm.StartFastForward(100, 0);
+        for (int i = 0; i < 99; i++) {
+            warm.ClockTick();
+        }
+        REQUIRE(warm.IsFastForwarding());
+        warm.ClockTick();
+        REQUIRE(!warm.IsFastForwarding());
+
+        warm.StartFastForward(0, 2);
+        warm.AddTransaction(0x40, false);
+        REQUIRE(warm.IsFastForwarding());
+        warm.AddTransaction(0x80, false);
+        REQUIRE(!warm.IsFastForwarding());
+    }
+
+    SECTION("TEST warmed rows are open in detailed mode") {
+        warm.StartFastForward(0, 1);
+        warm.AddTransaction(0x1000, false);
+        REQUIRE(!warm.IsFastForwarding());
+        warm.ClockTick();
+        // same row, different column
+        REQUIRE(ReadLatency(warm, 0x1040) < ReadLatency(cold, 0x1040));
+    }
+}
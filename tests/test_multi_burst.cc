@@ -0,0 +1,79 @@
+#include "catch.hpp"
+#include "memory_system.h"
+
+namespace {
+std::vector<uint64_t> mb_reads;
+void mb_read_back(uint64_t addr) { mb_reads.push_back(addr); }
+void mb_write_back(uint64_t addr) {}
+
+void RunUntilRead(dramsim3::MemorySystem& mem) {
+    mb_reads.clear();
+    for (int clk = 0; mb_reads.empty() && clk < 1000; clk++) {
+        mem.ClockTick();
+    }
+    // nothing else may come back
+    for (int clk = 0; clk < 100; clk++) {
+        mem.ClockTick();
+    }
+}
+}  // namespace
+
+TEST_CASE("Multi-burst transactions", "[multiburst][dramsim3]") {
+    SECTION("TEST a 256B read returns once after all its bursts") {
+        dramsim3::MemorySystem mem("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                   mb_read_back, mb_write_back);
+        REQUIRE(mem.WillAcceptSizedTransaction(0x1000, false, 256));
+        mem.AddSizedTransaction(0x1000, false, 256);
+        RunUntilRead(mem);
+        REQUIRE(mb_reads == std::vector<uint64_t>{0x1000});
+        auto stats = mem.GetStatsSnapshot();
+        REQUIRE(stats.num_reads_done == 4);
+        // one ACT, the other parts hit the open row
+        REQUIRE(stats.RowHitRate() == Approx(0.75));
+    }
+
+    SECTION("TEST a request spanning channels waits for all of them") {
+        dramsim3::MemorySystem mem(
+            "configs/DDR4_8Gb_x8_2400.ini", ".",
+            {{"system.channels", "2"},
+             {"system.address_mapping", "rorababgcoch"}},
+            mb_read_back, mb_write_back);
+        mem.AddSizedTransaction(0x1000, false, 256);
+        RunUntilRead(mem);
+        REQUIRE(mb_reads == std::vector<uint64_t>{0x1000});
+        REQUIRE(mem.GetStatsSnapshot().num_reads_done == 4);
+    }
+
+    SECTION("TEST a split request and a plain one to the same address") {
+        dramsim3::MemorySystem* mem_ptr = nullptr;
+        // reads done, in bursts, when each callback fires
+        std::vector<uint64_t> done_at_callback;
+        dramsim3::MemorySystem mem(
+            "configs/DDR4_8Gb_x8_2400.ini", ".",
+            {{"system.channels", "2"},
+             {"system.address_mapping", "rorababgcoch"}},
+            [&](uint64_t addr) {
+                done_at_callback.push_back(
+                    mem_ptr->GetStatsSnapshot().num_reads_done);
+            },
+            mb_write_back);
+        mem_ptr = &mem;
+        mem.AddSizedTransaction(0x1000, false, 256);
+        mem.AddTransaction(0x1000, false);
+        for (int clk = 0; clk < 1000; clk++) {
+            mem.ClockTick();
+        }
+        // the plain read returns with the first part, the split one only
+        // after both channels returned their two bursts each
+        REQUIRE(done_at_callback == std::vector<uint64_t>{1, 5});
+    }
+
+    SECTION("TEST a sub-burst read takes a single burst") {
+        dramsim3::MemorySystem mem("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                   mb_read_back, mb_write_back);
+        mem.AddSizedTransaction(0x1010, false, 32);
+        RunUntilRead(mem);
+        REQUIRE(mb_reads == std::vector<uint64_t>{0x1010});
+        REQUIRE(mem.GetStatsSnapshot().num_reads_done == 1);
+    }
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "channel_state.h"
+#include "configuration.h"
+#include "timing.h"
+
+TEST_CASE("Power-down modes", "[powerdown]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".");
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    dramsim3::Address rank_addr;
+    rank_addr.rank = 0;
+    dramsim3::Address addr(0, 0, 0, 0, 5, 0);
+    dramsim3::Command read(dramsim3::CommandType::READ, addr, 0);
+    dramsim3::Command pde(dramsim3::CommandType::PD_ENTER, rank_addr, -1);
+
+    SECTION("TEST active power-down keeps the row and pays tXP") {
+        channel_state.UpdateTimingAndStates(
+            dramsim3::Command(dramsim3::CommandType::ACTIVATE, addr, 0), 0);
+        uint64_t clk = config.tRCD;
+        auto cmd = channel_state.GetReadyCommand(pde, clk);
+        REQUIRE(cmd.cmd_type == dramsim3::CommandType::PD_ENTER);
+        channel_state.UpdateTimingAndStates(cmd, clk);
+        REQUIRE(channel_state.IsRankActivePowerDown(0));
+
+        // stays down for tCKE, then wakes up for the row hit
+        cmd = channel_state.GetReadyCommand(read, clk + config.tCKE - 1);
+        REQUIRE(!cmd.IsValid());
+        clk += config.tCKE;
+        cmd = channel_state.GetReadyCommand(read, clk);
+        REQUIRE(cmd.cmd_type == dramsim3::CommandType::PD_EXIT);
+        channel_state.UpdateTimingAndStates(cmd, clk);
+        REQUIRE(!channel_state.IsRankPoweredDown(0));
+        REQUIRE(!channel_state.GetReadyCommand(read, clk + config.tXP - 1)
+                     .IsValid());
+        cmd = channel_state.GetReadyCommand(read, clk + config.tXP);
+        REQUIRE(cmd.cmd_type == dramsim3::CommandType::READ);
+    }
+
+    SECTION("TEST precharge power-down wakes up closed") {
+        auto cmd = channel_state.GetReadyCommand(pde, 0);
+        REQUIRE(cmd.cmd_type == dramsim3::CommandType::PD_ENTER);
+        channel_state.UpdateTimingAndStates(cmd, 0);
+        REQUIRE(channel_state.IsRankPoweredDown(0));
+        REQUIRE(!channel_state.IsRankActivePowerDown(0));
+        cmd = channel_state.GetReadyCommand(read, config.tCKE);
+        channel_state.UpdateTimingAndStates(cmd, config.tCKE);
+        cmd = channel_state.GetReadyCommand(read, config.tCKE + config.tXP);
+        REQUIRE(cmd.cmd_type == dramsim3::CommandType::ACTIVATE);
+    }
+}
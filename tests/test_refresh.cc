@@ -0,0 +1,107 @@
+#include "catch.hpp"
+#include "channel_state.h"
+#include "command_queue.h"
+#include "configuration.h"
+#include "refresh.h"
+#include "simple_stats.h"
+#include "timing.h"
+
+namespace {
+// refresh slots alternate between the two ranks every tREFI / 2 cycles
+struct RefreshFixture {
+    RefreshFixture(const std::string& key, const std::string& value)
+        : config("configs/DDR4_8Gb_x8_2400.ini", ".", {{key, value}}),
+          timing(config),
+          channel_state(config, timing),
+          simple_stats(config, 0),
+          cmd_queue(0, config, channel_state, simple_stats),
+          refresh(0, config, channel_state, cmd_queue, simple_stats),
+          clk(0) {}
+    void TickTo(uint64_t target) {
+        for (; clk <= target; clk++) {
+            refresh.ClockTick();
+        }
+    }
+    dramsim3::Config config;
+    dramsim3::Timing timing;
+    dramsim3::ChannelState channel_state;
+    dramsim3::SimpleStats simple_stats;
+    dramsim3::CommandQueue cmd_queue;
+    dramsim3::Refresh refresh;
+    uint64_t clk;
+};
+}  // namespace
+
+TEST_CASE("Flexible refresh", "[refresh]") {
+    SECTION("TEST only a rank with queued commands postpones") {
+        RefreshFixture f("system.refresh_postpone", "2");
+        uint64_t slot = f.config.tREFI / f.config.ranks;
+        f.cmd_queue.AddCommand(dramsim3::Command(
+            dramsim3::CommandType::READ, dramsim3::Address(0, 0, 0, 0, 5, 0),
+            0));
+        // rank 0 is busy, rank 1 idle when their refreshes are due
+        f.TickTo(slot * 2);
+        REQUIRE(!f.channel_state.IsRankRefreshWaiting(0));
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(1));
+        REQUIRE(f.simple_stats.GetCounter("num_postponed_refs") == 1);
+        // up to refresh_postpone, then it is forced
+        f.TickTo(slot * 5);
+        REQUIRE(f.simple_stats.GetCounter("num_postponed_refs") == 2);
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(0));
+        REQUIRE(f.simple_stats.GetCounter("num_pulledin_refs") == 0);
+    }
+
+    SECTION("TEST idle ranks pull in up to refresh_pullin") {
+        RefreshFixture f("system.refresh_pullin", "1");
+        f.TickTo(0);
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(0));
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(1));
+        REQUIRE(f.simple_stats.GetCounter("num_pulledin_refs") == 2);
+        // once the refreshes are done the due ones are already paid for
+        f.channel_state.RankNeedRefresh(0, false);
+        f.channel_state.RankNeedRefresh(1, false);
+        f.TickTo(f.config.tREFI);
+        REQUIRE(f.simple_stats.GetCounter("num_pulledin_refs") == 4);
+        REQUIRE(f.simple_stats.GetCounter("num_postponed_refs") == 0);
+    }
+
+    SECTION("TEST powered-down ranks are not woken up to pull in") {
+        RefreshFixture f("system.refresh_pullin", "1");
+        dramsim3::Address rank_addr;
+        rank_addr.rank = 0;
+        f.channel_state.UpdateTimingAndStates(
+            dramsim3::Command(dramsim3::CommandType::PD_ENTER, rank_addr, 0),
+            0);
+        REQUIRE(f.channel_state.IsRankPoweredDown(0));
+        f.TickTo(f.config.tREFI / f.config.ranks - 1);
+        REQUIRE(!f.channel_state.IsRankRefreshWaiting(0));
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(1));
+        // a due refresh still wakes it
+        f.TickTo(f.config.tREFI / f.config.ranks);
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(0));
+    }
+
+    SECTION("TEST fast-forward keeps the row groups of self-refreshing ranks") {
+        RefreshFixture f("system.retention_aware", "true");
+        dramsim3::Address rank_addr;
+        rank_addr.rank = 1;
+        f.channel_state.UpdateTimingAndStates(
+            dramsim3::Command(dramsim3::CommandType::SREF_ENTER, rank_addr, 0),
+            0);
+        // one full 64ms round of row groups per rank
+        int num_groups =
+            static_cast<int>(64 * 1e6 / (f.config.tREFI * f.config.tCK));
+        uint64_t slot = f.config.tREFI / f.config.ranks;
+        f.clk = 2 * num_groups * slot + 1;
+        f.refresh.FastForward(f.clk);
+        f.channel_state.UpdateTimingAndStates(
+            dramsim3::Command(dramsim3::CommandType::SREF_EXIT, rank_addr, 0),
+            f.clk);
+        // rank 0 is in its second round, which only weak rows need, while
+        // rank 1 did not refresh at all and starts with its first group
+        f.TickTo(f.clk + 2 * slot - 1);
+        REQUIRE(!f.channel_state.IsRankRefreshWaiting(0));
+        REQUIRE(f.channel_state.IsRankRefreshWaiting(1));
+        REQUIRE(f.simple_stats.GetCounter("num_skipped_refs") == 1);
+    }
+}
@@ -0,0 +1,46 @@
+#include <cstdio>
+#include <fstream>
+#include "catch.hpp"
+#include "configuration.h"
+#include "retention.h"
+
+TEST_CASE("Bloom filter", "[retention]") {
+    dramsim3::BloomFilter filter(1024, 6);
+
+    SECTION("TEST inserted keys are always found") {
+        for (uint64_t key = 0; key < 50; key++) {
+            filter.Insert(key * 7919);
+        }
+        for (uint64_t key = 0; key < 50; key++) {
+            REQUIRE(filter.MayContain(key * 7919));
+        }
+        int false_positives = 0;
+        for (uint64_t key = 1000000; key < 1001000; key++) {
+            false_positives += filter.MayContain(key) ? 1 : 0;
+        }
+        REQUIRE(false_positives < 50);
+    }
+}
+
+TEST_CASE("Retention bins", "[retention]") {
+    const char* file_name = "test_retention.txt";
+    {
+        std::ofstream out(file_name);
+        out << "# channel rank bankgroup bank row retention_ms\n"
+            << "0 0 1 2 100 90\n"
+            << "0 0 3 0 200 150\n"
+            << "1 0 0 0 300 90\n";
+    }
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                            {{"system.retention_aware", "true"},
+                             {"system.retention_profile", file_name}});
+    dramsim3::RetentionBins bins(config, 0);
+
+    SECTION("TEST profiled rows get their refresh period") {
+        REQUIRE(bins.PeriodMultiple(0, 1, 2, 100) == 1);
+        REQUIRE(bins.PeriodMultiple(0, 3, 0, 200) == 2);
+        // rows of other channels are not binned here
+        REQUIRE(bins.PeriodMultiple(0, 0, 0, 300) == 4);
+    }
+    std::remove(file_name);
+}
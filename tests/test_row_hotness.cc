@@ -0,0 +1,53 @@
+#include "catch.hpp"
+#include "configuration.h"
+#include "row_hotness.h"
+
+TEST_CASE("Count-min sketch", "[hotness]") {
+    dramsim3::CountMinSketch sketch(64, 4);
+
+    SECTION("TEST estimates never undercount") {
+        for (uint64_t key = 0; key < 1000; key++) {
+            for (uint64_t i = 0; i < key % 7; i++) {
+                sketch.Add(key);
+            }
+        }
+        for (uint64_t key = 0; key < 1000; key++) {
+            REQUIRE(sketch.Estimate(key) >= key % 7);
+        }
+        sketch.Clear();
+        REQUIRE(sketch.Estimate(3) == 0);
+    }
+}
+
+TEST_CASE("Row hotness", "[hotness]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                            {{"other.row_hotness", "true"},
+                             {"other.hot_rows_topk", "2"}});
+    dramsim3::RowHotness hotness(config);
+
+    SECTION("TEST heavy hitters are reported hottest first") {
+        dramsim3::Address hot(0, 0, 1, 2, 100, 0);
+        dramsim3::Address warm(0, 0, 3, 1, 7, 0);
+        for (int i = 0; i < 50; i++) {
+            hotness.Activate(hot);
+            if (i % 2 == 0) {
+                hotness.Activate(warm);
+            }
+            // a stream of cold rows must not push out the hot ones
+            hotness.Activate(dramsim3::Address(0, 0, 0, 0, 1000 + i, 0));
+        }
+        auto rows = hotness.HotRows();
+        REQUIRE(rows.size() == 2);
+        REQUIRE(rows[0]["bankgroup"] == 1);
+        REQUIRE(rows[0]["bank"] == 2);
+        REQUIRE(rows[0]["row"] == 100);
+        REQUIRE(rows[0]["activations"] >= 50);
+        REQUIRE(rows[1]["row"] == 7);
+        REQUIRE(hotness.Estimate(warm) >= 25);
+
+        hotness.ClearEpoch();
+        REQUIRE(hotness.EpochHotRows().empty());
+        REQUIRE(hotness.EpochEstimate(hot) == 0);
+        REQUIRE(hotness.Estimate(hot) >= 50);
+    }
+}
@@ -0,0 +1,20 @@
+#include "catch.hpp"
+#include "row_predictor.h"
+
+TEST_CASE("Row buffer predictor", "[rowpolicy]") {
+    dramsim3::RowPredictor predictor(2, 2);
+
+    SECTION("TEST banks learn their own locality") {
+        REQUIRE(predictor.KeepOpen(0));
+        // bank 0 streams through one row, bank 1 jumps around
+        for (int i = 0; i < 4; i++) {
+            predictor.Update(0, 7);
+            predictor.Update(1, i);
+        }
+        REQUIRE(predictor.KeepOpen(0));
+        REQUIRE(!predictor.KeepOpen(1));
+        // a closing bank mispredicts once a hit comes along
+        REQUIRE(!predictor.Update(1, 3));
+        REQUIRE(predictor.Update(0, 7));
+    }
+}
@@ -0,0 +1,165 @@
+#include "catch.hpp"
+#include "channel_state.h"
+#include "command_queue.h"
+#include "configuration.h"
+#include "scheduler.h"
+#include "timing.h"
+
+namespace {
+dramsim3::Command MakeRead(int bank, int row, uint32_t source) {
+    dramsim3::Command cmd(dramsim3::CommandType::READ,
+                          dramsim3::Address(0, 0, 0, bank, row, 0),
+                          (static_cast<uint64_t>(row) << 8) | bank);
+    cmd.source = source;
+    return cmd;
+}
+}  // namespace
+
+TEST_CASE("Command schedulers", "[scheduler]") {
+    SECTION("TEST FCFS only considers the oldest command of a bank") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.scheduler", "FCFS"}});
+        auto scheduler = dramsim3::MakeScheduler(config);
+        dramsim3::CMDQueue queue = {MakeRead(0, 1, 0), MakeRead(1, 1, 0),
+                                    MakeRead(0, 2, 0)};
+        REQUIRE(scheduler->IsEligible(queue, 0));
+        REQUIRE(scheduler->IsEligible(queue, 1));
+        REQUIRE(!scheduler->IsEligible(queue, 2));
+        REQUIRE(!scheduler->HoldPrecharge(0));
+    }
+
+    SECTION("TEST FR-FCFS caps the row hits that hold a precharge") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.row_hit_cap", "2"}});
+        auto scheduler = dramsim3::MakeScheduler(config);
+        REQUIRE(scheduler->HoldPrecharge(1));
+        REQUIRE(!scheduler->HoldPrecharge(2));
+    }
+
+    SECTION("TEST BLISS blacklists a source served too often in a row") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.scheduler", "BLISS"},
+                                 {"system.num_sources", "2"},
+                                 {"system.bliss_threshold", "3"},
+                                 {"system.bliss_clear_interval", "100"}});
+        auto scheduler = dramsim3::MakeScheduler(config);
+        auto hog = MakeRead(0, 1, 0);
+        auto other = MakeRead(1, 1, 1);
+        REQUIRE(scheduler->Priority(hog, hog) ==
+                scheduler->Priority(other, other));
+        for (int i = 0; i < 3; i++) {
+            scheduler->CommandIssued(hog, i);
+        }
+        REQUIRE(scheduler->Priority(hog, hog) <
+                scheduler->Priority(other, other));
+        std::vector<dramsim3::CMDQueue> queues;
+        scheduler->ClockTick(queues, 100);
+        REQUIRE(scheduler->Priority(hog, hog) ==
+                scheduler->Priority(other, other));
+    }
+
+    SECTION("TEST PAR-BS serves the marked batch first") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.scheduler", "PARBS"},
+                                 {"system.parbs_batch_cap", "1"}});
+        auto scheduler = dramsim3::MakeScheduler(config);
+        std::vector<dramsim3::CMDQueue> queues = {
+            {MakeRead(0, 1, 0), MakeRead(0, 2, 0)}};
+        scheduler->ClockTick(queues, 1);
+        auto priority = [&](int i) {
+            return scheduler->Priority(queues[0][i], queues[0][i]);
+        };
+        REQUIRE(priority(0) > priority(1));
+        // marks belong to commands, not addresses: a later command to the
+        // same address is not part of the batch
+        queues[0].push_back(MakeRead(0, 1, 0));
+        REQUIRE(priority(2) < priority(0));
+        scheduler->CommandIssued(queues[0][2], 2);
+        queues[0].pop_back();
+        scheduler->ClockTick(queues, 2);
+        REQUIRE(priority(0) == scheduler->MaxPriority());
+        // a new batch forms once the marked command is served
+        scheduler->CommandIssued(queues[0][0], 3);
+        queues[0].erase(queues[0].begin());
+        scheduler->ClockTick(queues, 4);
+        REQUIRE(priority(0) == scheduler->MaxPriority());
+    }
+
+    SECTION("TEST ATLAS ranks by attained service and lets starved through") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.scheduler", "ATLAS"},
+                                 {"system.num_sources", "2"},
+                                 {"system.atlas_quantum", "100"},
+                                 {"system.atlas_starvation", "50"}});
+        auto scheduler = dramsim3::MakeScheduler(config);
+        auto hog = MakeRead(0, 1, 0);
+        auto other = MakeRead(1, 1, 1);
+        std::vector<dramsim3::CMDQueue> queues;
+        scheduler->ClockTick(queues, 0);
+        for (int i = 0; i < 4; i++) {
+            scheduler->CommandIssued(hog, i);
+        }
+        // ties go to the lower source, the ranking only changes at the end
+        // of a quantum
+        scheduler->ClockTick(queues, 10);
+        REQUIRE(scheduler->Priority(hog, hog) >
+                scheduler->Priority(other, other));
+        scheduler->ClockTick(queues, 100);
+        REQUIRE(scheduler->Priority(hog, hog) <
+                scheduler->Priority(other, other));
+        // a command waiting past atlas_starvation goes ahead regardless
+        hog.added_cycle = 100;
+        other.added_cycle = 140;
+        scheduler->ClockTick(queues, 151);
+        REQUIRE(scheduler->Priority(hog, hog) >
+                scheduler->Priority(other, other));
+        REQUIRE(scheduler->Priority(hog, hog) <= scheduler->MaxPriority());
+    }
+}
+
+TEST_CASE("Bankgroup interleaving", "[scheduler]") {
+    auto next_read = [](bool interleave) {
+        dramsim3::Config config(
+            "configs/DDR4_8Gb_x8_2400.ini", ".",
+            {{"system.bankgroup_interleave", interleave ? "true" : "false"}});
+        dramsim3::Timing timing(config);
+        dramsim3::ChannelState channel_state(config, timing);
+        dramsim3::SimpleStats simple_stats(config, 0);
+        dramsim3::CommandQueue cmd_queue(0, config, channel_state,
+                                         simple_stats);
+        // rows open in bankgroup 0 banks 0 and 1 and in bankgroup 1 bank 0
+        auto read = [](int bankgroup, int bank, int column) {
+            return dramsim3::Command(
+                dramsim3::CommandType::READ,
+                dramsim3::Address(0, 0, bankgroup, bank, 5, column),
+                (bankgroup << 8) | (bank << 4) | column);
+        };
+        for (const auto& cmd : {read(0, 0, 0), read(0, 1, 0), read(1, 0, 0)}) {
+            channel_state.UpdateTimingAndStates(
+                dramsim3::Command(dramsim3::CommandType::ACTIVATE, cmd.addr,
+                                  cmd.hex_addr),
+                0);
+        }
+        uint64_t clk = 0;
+        auto tick_to = [&](uint64_t target) {
+            for (; clk < target; clk++) {
+                cmd_queue.ClockTick();
+            }
+        };
+        tick_to(config.tRCD);
+        cmd_queue.AddCommand(read(0, 0, 0));
+        auto cmd = cmd_queue.GetCommandToIssue();
+        REQUIRE(cmd.Bankgroup() == 0);
+        channel_state.UpdateTimingAndStates(cmd, clk);
+        // both are ready once tCCD_L has passed, round robin reaches bank 1
+        // of bankgroup 0 first
+        cmd_queue.AddCommand(read(0, 1, 1));
+        cmd_queue.AddCommand(read(1, 0, 1));
+        tick_to(clk + config.tCCD_L);
+        cmd = cmd_queue.GetCommandToIssue();
+        REQUIRE(cmd.IsRead());
+        return cmd.Bankgroup();
+    };
+    REQUIRE(next_read(false) == 0);
+    REQUIRE(next_read(true) == 1);
+}
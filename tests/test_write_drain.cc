@@ -0,0 +1,110 @@
+#include "catch.hpp"
+#include "configuration.h"
+#include "controller.h"
+#include "timing.h"
+
+namespace {
+uint64_t WriteAddr(const dramsim3::Config& config, int bank, int row,
+                   int col) {
+    uint64_t addr = (static_cast<uint64_t>(row) << config.ro_pos) |
+                    (static_cast<uint64_t>(bank) << config.ba_pos) |
+                    (static_cast<uint64_t>(col) << config.co_pos);
+    return addr << config.shift_bits;
+}
+
+void Tick(dramsim3::Controller& ctrl, int cycles) {
+    for (int i = 0; i < cycles; i++) {
+        ctrl.ClockTick();
+    }
+}
+
+// writes that left the write buffer, queued or issued
+uint64_t WritesDrained(const dramsim3::Controller& ctrl) {
+    return ctrl.QueueUsage() + ctrl.GetStatsSnapshot().num_rw_cmds;
+}
+}  // namespace
+
+TEST_CASE("Write draining", "[writebuffer]") {
+    SECTION("TEST idle draining starts above write_min_drain") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".");
+        dramsim3::Timing timing(config);
+        dramsim3::Controller ctrl(0, config, timing);
+        for (int i = 0; i < config.write_min_drain; i++) {
+            ctrl.AddTransaction(
+                dramsim3::Transaction(WriteAddr(config, i % 4, 0, i), true));
+        }
+        Tick(ctrl, 200);
+        REQUIRE(WritesDrained(ctrl) == 0);
+        ctrl.AddTransaction(dramsim3::Transaction(
+            WriteAddr(config, 0, 0, config.write_min_drain), true));
+        Tick(ctrl, 200);
+        REQUIRE(ctrl.GetStatsSnapshot().num_rw_cmds ==
+                static_cast<uint64_t>(config.write_min_drain + 1));
+    }
+
+    SECTION("TEST a full buffer drains down to the low watermark") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.write_high_watermark", "12"},
+                                 {"system.write_low_watermark", "4"},
+                                 {"system.write_min_drain", "2"}});
+        dramsim3::Timing timing(config);
+        dramsim3::Controller ctrl(0, config, timing);
+        for (int i = 0; i < 12; i++) {
+            ctrl.AddTransaction(
+                dramsim3::Transaction(WriteAddr(config, i % 4, 0, i), true));
+        }
+        // the rest waits until the command queues run empty
+        Tick(ctrl, 30);
+        REQUIRE(WritesDrained(ctrl) == 8);
+        // then idle drains send write_min_drain until no more than that is
+        // left
+        Tick(ctrl, 500);
+        REQUIRE(ctrl.GetStatsSnapshot().num_rw_cmds == 10);
+    }
+
+    SECTION("TEST the oldest write drains after write_max_age") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.write_max_age", "100"}});
+        dramsim3::Timing timing(config);
+        dramsim3::Controller ctrl(0, config, timing);
+        ctrl.AddTransaction(
+            dramsim3::Transaction(WriteAddr(config, 0, 0, 0), true));
+        Tick(ctrl, 100);
+        REQUIRE(WritesDrained(ctrl) == 0);
+        Tick(ctrl, 1);
+        REQUIRE(WritesDrained(ctrl) == 1);
+    }
+
+    SECTION("TEST writes to the same line coalesce") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.write_coalescing", "true"},
+                                 {"system.write_max_age", "10"}});
+        dramsim3::Timing timing(config);
+        dramsim3::Controller ctrl(0, config, timing);
+        uint64_t addr = WriteAddr(config, 0, 0, 0);
+        ctrl.AddTransaction(dramsim3::Transaction(addr, true));
+        ctrl.AddTransaction(dramsim3::Transaction(addr + 8, true));
+        ctrl.AddTransaction(
+            dramsim3::Transaction(WriteAddr(config, 0, 0, 1), true));
+        Tick(ctrl, 200);
+        REQUIRE(ctrl.GetStatsSnapshot().num_rw_cmds == 2);
+    }
+
+    SECTION("TEST coalescing drains the open row first") {
+        dramsim3::Config config("configs/DDR4_8Gb_x8_2400.ini", ".",
+                                {{"system.write_coalescing", "true"},
+                                 {"system.cmd_queue_size", "1"},
+                                 {"system.write_min_drain", "1"}});
+        dramsim3::Timing timing(config);
+        dramsim3::Controller ctrl(0, config, timing);
+        // alternating rows of one bank, in FIFO order each is a row miss
+        for (int i = 0; i < 4; i++) {
+            ctrl.AddTransaction(
+                dramsim3::Transaction(WriteAddr(config, 0, i % 2, i), true));
+        }
+        Tick(ctrl, 500);
+        auto stats = ctrl.GetStatsSnapshot();
+        REQUIRE(stats.num_rw_cmds == 4);
+        REQUIRE(stats.num_row_hits == 2);
+    }
+}